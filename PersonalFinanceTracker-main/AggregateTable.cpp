@@ -0,0 +1,127 @@
+#include "AggregateTable.h"
+#include "CategoryRegistry.h"
+#include "PackedDate.h"
+#include <algorithm>
+
+void AggregateTable::clear() {
+    months.clear();
+}
+
+Totals& AggregateTable::slot(MonthEntry& entry, uint16_t category) {
+    if (category >= entry.categories.size()) {
+        entry.categories.resize(std::max<size_t>(category + 1, CategoryRegistry::COUNT));
+    }
+    return entry.categories[category];
+}
+
+// Adds one transaction to its month and category buckets.
+void AggregateTable::add(const Transaction& transaction) {
+    MonthEntry& entry = months[packedMonth(transaction.getDate())];
+    Totals& category = slot(entry, transaction.getCategoryId());
+
+    if (transaction.getType() == TransactionType::Income) {
+        entry.total.income += transaction.getAmount();
+        category.income += transaction.getAmount();
+    } else {
+        entry.total.expense += transaction.getAmount();
+        category.expense += transaction.getAmount();
+    }
+}
+
+// Subtracts a row that add() saw earlier.
+void AggregateTable::remove(const Transaction& transaction) {
+    MonthEntry& entry = months[packedMonth(transaction.getDate())];
+    Totals& category = slot(entry, transaction.getCategoryId());
+
+    if (transaction.getType() == TransactionType::Income) {
+        entry.total.income -= transaction.getAmount();
+        category.income -= transaction.getAmount();
+    } else {
+        entry.total.expense -= transaction.getAmount();
+        category.expense -= transaction.getAmount();
+    }
+}
+
+// Adds a partial table built with its own category ids (mapped through categoryRemap).
+void AggregateTable::merge(const AggregateTable& other, const std::vector<uint16_t>& categoryRemap) {
+    for (const auto& month : other.months) {
+        MonthEntry& entry = months[month.first];
+        entry.total.income += month.second.total.income;
+        entry.total.expense += month.second.total.expense;
+
+        const std::vector<Totals>& categories = month.second.categories;
+        for (size_t id = 0; id < categories.size() && id < categoryRemap.size(); ++id) {
+            Totals& target = slot(entry, categoryRemap[id]);
+            target.income += categories[id].income;
+            target.expense += categories[id].expense;
+        }
+    }
+}
+
+// Adds a partial table whose category ids already match this one (e.g. one import batch).
+void AggregateTable::merge(const AggregateTable& other) {
+    for (const auto& month : other.months) {
+        MonthEntry& entry = months[month.first];
+        entry.total.income += month.second.total.income;
+        entry.total.expense += month.second.total.expense;
+
+        const std::vector<Totals>& categories = month.second.categories;
+        for (size_t id = 0; id < categories.size(); ++id) {
+            Totals& target = slot(entry, static_cast<uint16_t>(id));
+            target.income += categories[id].income;
+            target.expense += categories[id].expense;
+        }
+    }
+}
+
+std::vector<AggregateEntry> AggregateTable::entries() const {
+    std::vector<AggregateEntry> list;
+    for (const auto& month : months) {
+        const std::vector<Totals>& categories = month.second.categories;
+        for (size_t id = 0; id < categories.size(); ++id) {
+            const Totals& totals = categories[id];
+            if (totals.income.cents() == 0 && totals.expense.cents() == 0) continue;
+            list.push_back({month.first, static_cast<uint16_t>(id), totals.income.cents(), totals.expense.cents()});
+        }
+    }
+    return list;
+}
+
+void AggregateTable::addEntry(const AggregateEntry& entry) {
+    MonthEntry& month = months[entry.month];
+    Totals& category = slot(month, entry.category);
+    Money income = Money::fromCents(entry.income), expense = Money::fromCents(entry.expense);
+    month.total.income += income;
+    month.total.expense += expense;
+    category.income += income;
+    category.expense += expense;
+}
+
+// Totals for a month such as "2025-04". Empty if nothing was recorded.
+Totals AggregateTable::monthTotals(const std::string& month) const {
+    int32_t key;
+    if (!packMonth(month, key)) return Totals();
+
+    auto it = months.find(key);
+    if (it == months.end()) return Totals();
+    return it->second.total;
+}
+
+std::vector<std::pair<int32_t, Totals>> AggregateTable::sortedMonths() const {
+    std::vector<std::pair<int32_t, Totals>> list;
+    list.reserve(months.size());
+    for (const auto& month : months) list.emplace_back(month.first, month.second.total);
+    std::sort(list.begin(), list.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return list;
+}
+
+// Per-category totals for a month, indexed by CategoryPool id. Ids past the end had nothing recorded.
+const std::vector<Totals>& AggregateTable::categoryTotals(const std::string& month) const {
+    static const std::vector<Totals> empty;
+    int32_t key;
+    if (!packMonth(month, key)) return empty;
+
+    auto it = months.find(key);
+    if (it == months.end()) return empty;
+    return it->second.categories;
+}
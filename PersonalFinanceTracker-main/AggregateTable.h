@@ -0,0 +1,51 @@
+#ifndef AGGREGATETABLE_H
+#define AGGREGATETABLE_H
+#include "Transaction.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Income and expense totals for one bucket.
+struct Totals {
+    Money income;
+    Money expense;
+};
+
+// One (month, category) bucket in flat form, used to save and restore the table.
+struct AggregateEntry {
+    int32_t month;      // packedMonth()
+    uint16_t category;  // CategoryPool id
+    int64_t income;     // cents
+    int64_t expense;    // cents
+};
+
+// Running income/expense totals keyed by (month, category). Updated as rows are
+// added, so month-level questions are answered without looking at the ledger.
+class AggregateTable {
+public:
+    void clear();
+    void add(const Transaction& transaction);       // fold one row into the totals
+    void remove(const Transaction& transaction);    // take a deleted or replaced row back out
+    void merge(const AggregateTable& other, const std::vector<uint16_t>& categoryRemap); // add another table's totals
+    void merge(const AggregateTable& other);        // same, when both tables use CategoryPool ids
+
+    std::vector<AggregateEntry> entries() const;    // every bucket, for snapshots
+    void addEntry(const AggregateEntry& entry);     // fold a saved bucket back in
+
+    Totals monthTotals(const std::string& month) const;                        // whole month, "YYYY-MM"
+    std::vector<std::pair<int32_t, Totals>> sortedMonths() const;              // (packed month, totals) in month order
+    const std::vector<Totals>& categoryTotals(const std::string& month) const; // indexed by category id, may be short
+
+private:
+    struct MonthEntry {
+        Totals total;
+        std::vector<Totals> categories; // indexed by CategoryPool id
+    };
+
+    static Totals& slot(MonthEntry& entry, uint16_t category); // grows categories to reach the id
+
+    std::unordered_map<int32_t, MonthEntry> months; // keyed by packedMonth()
+};
+
+#endif
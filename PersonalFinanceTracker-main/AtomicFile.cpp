@@ -0,0 +1,43 @@
+#include "AtomicFile.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool writeFileAtomically(const std::string& path, const std::string& contents) {
+    std::string tempPath = path + ".tmp";
+
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+
+    bool ok = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    ok = ok && syncFile(file);
+    ok = std::fclose(file) == 0 && ok;
+
+    if (!ok || !replaceFile(tempPath, path)) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
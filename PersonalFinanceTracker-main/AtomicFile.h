@@ -0,0 +1,17 @@
+#ifndef ATOMICFILE_H
+#define ATOMICFILE_H
+#include <cstdio>
+#include <string>
+
+// Replaces path with contents so readers see either the old file or the new
+// one, never a half-written file: write path + ".tmp", flush it to disk, then
+// rename it over the original.
+bool writeFileAtomically(const std::string& path, const std::string& contents);
+
+// Renames from over to, replacing to if it exists.
+bool replaceFile(const std::string& from, const std::string& to);
+
+// Flushes the stdio buffer and forces the file's data out to disk.
+bool syncFile(std::FILE* file);
+
+#endif
@@ -0,0 +1,286 @@
+#include "BinaryLedger.h"
+#include "AtomicFile.h"
+#include "CategoryPool.h"
+#include "PackedDate.h"
+#include "TransactionStore.h"
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+static const char LEDGER_MAGIC[8] = {'P', 'F', 'T', 'L', 'E', 'D', 'G', 'R'};
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+static const uint32_t MAX_CATEGORIES = 256;
+static const size_t MAX_CATEGORY_LENGTH = 31;
+
+// A fresh header with no records and no categories.
+static void initHeader(BinaryLedgerHeader& header) {
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LEDGER_MAGIC, sizeof(LEDGER_MAGIC));
+    header.version = BinaryLedger::VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.headerSize = sizeof(BinaryLedgerHeader);
+    header.recordSize = sizeof(BinaryRecord);
+}
+
+// Checks magic, version and layout so an old or foreign file is never misread.
+// fileSize is the length of the whole file, which must hold at least the header.
+static bool checkHeader(const BinaryLedgerHeader& header, uint64_t fileSize, std::string& error) {
+    if (std::memcmp(header.magic, LEDGER_MAGIC, sizeof(LEDGER_MAGIC)) != 0) {
+        error = "not a binary ledger file";
+        return false;
+    }
+    if (header.version != BinaryLedger::VERSION) {
+        error = "unsupported binary ledger version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.byteOrder != BYTE_ORDER_MARK || header.recordSize != sizeof(BinaryRecord) ||
+        header.headerSize < sizeof(BinaryLedgerHeader) || header.categoryCount > MAX_CATEGORIES) {
+        error = "binary ledger was written with an incompatible layout";
+        return false;
+    }
+    if (header.headerSize > fileSize) {
+        error = "binary ledger is truncated";
+        return false;
+    }
+    for (uint32_t i = 0; i < header.categoryCount; ++i) {
+        if (!std::memchr(header.categories[i], '\0', sizeof(header.categories[i]))) {
+            error = "binary ledger has a damaged category table";
+            return false;
+        }
+    }
+    return true;
+}
+
+// 64-bit seek and tell, so offsets past 2 GB work where long is 32 bits (Windows).
+static bool seekTo(std::FILE* file, uint64_t offset, int origin) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), origin) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), origin) == 0;
+#endif
+}
+
+static bool fileLength(std::FILE* file, uint64_t& length) {
+    if (!seekTo(file, 0, SEEK_END)) return false;
+#ifdef _WIN32
+    __int64 end = _ftelli64(file);
+#else
+    off_t end = ftello(file);
+#endif
+    if (end < 0) return false;
+    length = static_cast<uint64_t>(end);
+    return true;
+}
+
+// Returns the id for name, adding it to the header table if needed. -1 if it cannot be stored.
+static int findOrAddCategory(BinaryLedgerHeader& header, std::string_view name) {
+    for (uint32_t i = 0; i < header.categoryCount; ++i) {
+        if (name == header.categories[i]) return static_cast<int>(i);
+    }
+    if (header.categoryCount >= MAX_CATEGORIES || name.size() > MAX_CATEGORY_LENGTH) return -1;
+
+    std::memcpy(header.categories[header.categoryCount], name.data(), name.size());
+    header.categories[header.categoryCount][name.size()] = '\0';
+    return static_cast<int>(header.categoryCount++);
+}
+
+// Fills a record from transaction fields. Returns false with a reason if the category does not fit.
+static bool makeRecord(BinaryLedgerHeader& header, int32_t date, TransactionType type,
+                       std::string_view category, int64_t cents, BinaryRecord& record, std::string& error) {
+    std::memset(&record, 0, sizeof(record));
+
+    int id = findOrAddCategory(header, category);
+    if (id < 0) {
+        error = "category name too long or too many categories";
+        return false;
+    }
+
+    record.date = date;
+    record.type = type == TransactionType::Income ? BinaryLedger::INCOME : BinaryLedger::EXPENSE;
+    record.category = static_cast<uint16_t>(id);
+    record.cents = cents;
+    return true;
+}
+
+bool BinaryLedgerReader::open(const std::string& path, std::string& error) {
+    header = nullptr;
+    records = nullptr;
+    count = 0;
+
+    if (!file.open(path)) {
+        error = "could not open " + path;
+        return false;
+    }
+    if (file.size() < sizeof(BinaryLedgerHeader)) {
+        error = "binary ledger is truncated";
+        return false;
+    }
+
+    header = reinterpret_cast<const BinaryLedgerHeader*>(file.data());
+    if (!checkHeader(*header, file.size(), error)) return false;
+
+    // Trust the committed count, but never read past a partly written tail.
+    size_t available = (file.size() - header->headerSize) / sizeof(BinaryRecord);
+    count = static_cast<size_t>(header->recordCount) < available ? static_cast<size_t>(header->recordCount) : available;
+    records = reinterpret_cast<const BinaryRecord*>(file.data() + header->headerSize);
+
+    categoryIds.clear();
+    for (uint32_t i = 0; i < header->categoryCount; ++i) {
+        categoryIds.push_back(CategoryPool::intern(std::string_view(header->categories[i])));
+    }
+    return true;
+}
+
+const char* BinaryLedgerReader::categoryName(uint16_t id) const {
+    if (id >= header->categoryCount) return "";
+    return header->categories[id];
+}
+
+uint32_t BinaryLedgerReader::categoryCount() const {
+    return header ? header->categoryCount : 0;
+}
+
+// Converts a file record to the in-memory Transaction; only the category id needs translating.
+Transaction BinaryLedgerReader::toTransaction(const BinaryRecord& record) const {
+    uint16_t category = record.category < categoryIds.size() ? categoryIds[record.category]
+                                                             : CategoryPool::intern(std::string_view());
+    return Transaction(record.type == BinaryLedger::INCOME ? TransactionType::Income : TransactionType::Expense,
+                       Money::fromCents(record.cents), category, record.date);
+}
+
+bool BinaryLedger::append(const std::string& path, const Transaction& transaction, std::string& error) {
+    return appendBatch(path, std::vector<Transaction>{transaction}, error);
+}
+
+// Writes the records after the committed data, syncs them, then bumps the count in the header.
+// A crash before the header update leaves the old count, so half-written batches are ignored.
+bool BinaryLedger::appendBatch(const std::string& path, const std::vector<Transaction>& transactions,
+                               std::string& error) {
+    BinaryLedgerHeader header;
+    std::FILE* file = std::fopen(path.c_str(), "r+b");
+
+    if (file) {
+        uint64_t length = 0;
+        if (std::fread(&header, sizeof(header), 1, file) != 1 || !fileLength(file, length)) {
+            std::fclose(file);
+            error = "binary ledger is truncated";
+            return false;
+        }
+        if (!checkHeader(header, length, error)) {
+            std::fclose(file);
+            return false;
+        }
+        // Records are written before the count, so the file always holds every committed one.
+        if (header.recordCount > (length - header.headerSize) / sizeof(BinaryRecord)) {
+            std::fclose(file);
+            error = "binary ledger is truncated";
+            return false;
+        }
+    } else {
+        // First write creates the file.
+        file = std::fopen(path.c_str(), "w+b");
+        if (!file) {
+            error = "could not create " + path;
+            return false;
+        }
+        initHeader(header);
+    }
+
+    std::vector<BinaryRecord> records(transactions.size());
+    for (size_t i = 0; i < transactions.size(); ++i) {
+        const Transaction& t = transactions[i];
+        if (!makeRecord(header, t.getDate(), t.getType(), t.getCategory(), t.getAmount().cents(), records[i], error)) {
+            std::fclose(file);
+            return false;
+        }
+    }
+
+    uint64_t offset = header.headerSize + header.recordCount * sizeof(BinaryRecord);
+    bool ok = seekTo(file, offset, SEEK_SET) &&
+              std::fwrite(records.data(), sizeof(BinaryRecord), records.size(), file) == records.size() &&
+              syncFile(file);
+
+    if (ok) {
+        header.recordCount += records.size();
+        ok = seekTo(file, 0, SEEK_SET) &&
+             std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+             syncFile(file);
+    }
+
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool BinaryLedger::convertTextToBinary(const std::string& textPath, const std::string& binaryPath,
+                                       size_t& written, size_t& skipped, std::string& error) {
+    written = 0;
+    skipped = 0;
+
+    BinaryLedgerHeader header;
+    initHeader(header);
+    std::vector<BinaryRecord> records;
+    std::string rowError;
+
+    // Through the store, so deletions and edits in the text are applied first.
+    TransactionStore store;
+    if (!store.loadFromFile(textPath)) {
+        error = "could not open " + textPath;
+        return false;
+    }
+    skipped = store.loadErrors().size();
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (!store.isLive(i)) continue;
+        Transaction t = store.at(i);
+        BinaryRecord record;
+        if (makeRecord(header, t.getDate(), t.getType(), t.getCategory(), t.getAmount().cents(), record, rowError)) {
+            records.push_back(record);
+        } else {
+            ++skipped;
+        }
+    }
+
+    // Built in memory and swapped in whole, so a failed write never leaves a truncated ledger.
+    header.recordCount = records.size();
+    std::string contents(reinterpret_cast<const char*>(&header), sizeof(header));
+    contents.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(BinaryRecord));
+    if (!writeFileAtomically(binaryPath, contents)) {
+        error = "could not write " + binaryPath;
+        return false;
+    }
+
+    written = records.size();
+    return true;
+}
+
+bool BinaryLedger::convertBinaryToText(const std::string& binaryPath, const std::string& textPath,
+                                       size_t& written, std::string& error) {
+    written = 0;
+
+    BinaryLedgerReader reader;
+    if (!reader.open(binaryPath, error)) return false;
+
+    std::string contents;
+    for (size_t i = 0; i < reader.size(); ++i) {
+        const BinaryRecord& record = reader.record(i);
+
+        contents += unpackDate(record.date);
+        contents += record.type == INCOME ? ",income," : ",expense,";
+        contents += reader.categoryName(record.category);
+        contents += ',';
+        contents += Money::fromCents(record.cents).toString();
+        contents += '\n';
+    }
+
+    // Swapped in whole, like the other direction, so the old text ledger survives a failed write.
+    if (!writeFileAtomically(textPath, contents)) {
+        error = "could not write " + textPath;
+        return false;
+    }
+    written = reader.size();
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef BINARYLEDGER_H
+#define BINARYLEDGER_H
+#include "MappedFile.h"
+#include "Transaction.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk layout of the binary ledger (little-endian):
+//   BinaryLedgerHeader, then recordCount fixed-width BinaryRecord entries.
+// Categories are stored once in the header and records refer to them by id.
+
+#pragma pack(push, 1)
+struct BinaryLedgerHeader {
+    char magic[8];              // "PFTLEDGR"
+    uint32_t version;           // BinaryLedger::VERSION
+    uint32_t byteOrder;         // 0x01020304 as written by the host
+    uint32_t headerSize;        // offset of the first record
+    uint32_t recordSize;        // sizeof(BinaryRecord)
+    uint64_t recordCount;       // records committed after the header
+    uint32_t categoryCount;     // used entries in categories[]
+    uint32_t reserved[7];
+    char categories[256][32];   // NUL-terminated category names, indexed by id
+};
+
+struct BinaryRecord {
+    int32_t date;       // packed date, see PackedDate.h
+    uint8_t type;       // BinaryLedger::EXPENSE or BinaryLedger::INCOME
+    uint8_t flags;      // reserved, always 0
+    uint16_t category;  // index into BinaryLedgerHeader::categories
+    int64_t cents;      // amount in integer cents
+};
+#pragma pack(pop)
+
+static_assert(sizeof(BinaryRecord) == 16, "binary ledger records must stay 16 bytes");
+
+// Read-only, zero-copy view of a binary ledger through a memory mapping.
+class BinaryLedgerReader {
+public:
+    bool open(const std::string& path, std::string& error);
+
+    size_t size() const { return count; }
+    const BinaryRecord& record(size_t i) const { return records[i]; }
+    const char* categoryName(uint16_t id) const;
+    uint32_t categoryCount() const;
+
+    Transaction toTransaction(const BinaryRecord& record) const; // in-memory form, category re-interned
+
+private:
+    MappedFile file;
+    std::vector<uint16_t> categoryIds;   // file category id -> CategoryPool id
+    const BinaryLedgerHeader* header = nullptr;
+    const BinaryRecord* records = nullptr;
+    size_t count = 0;
+};
+
+// Writing side of the binary format plus the converters to and from the CSV ledger.
+class BinaryLedger {
+public:
+    static const uint32_t VERSION = 1;
+    static const uint8_t EXPENSE = 0;
+    static const uint8_t INCOME = 1;
+
+    // Appends one record, adding its category to the header when new.
+    static bool append(const std::string& path, const Transaction& transaction, std::string& error);
+
+    // Appends many records with one write and one sync (group commit).
+    static bool appendBatch(const std::string& path, const std::vector<Transaction>& transactions, std::string& error);
+
+    // data/transactions.txt -> binary. Malformed lines are skipped and counted in skipped.
+    static bool convertTextToBinary(const std::string& textPath, const std::string& binaryPath,
+                                    size_t& written, size_t& skipped, std::string& error);
+
+    // Binary -> "date,type,category,amount" lines with two decimal places.
+    static bool convertBinaryToText(const std::string& binaryPath, const std::string& textPath,
+                                    size_t& written, std::string& error);
+};
+
+#endif
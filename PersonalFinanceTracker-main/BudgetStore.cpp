@@ -0,0 +1,188 @@
+#include "BudgetStore.h"
+#include "AtomicFile.h"
+#include "PackedDate.h"
+#include <algorithm>
+#include <fstream>
+#include <string_view>
+
+BudgetStore::BudgetStore(size_t compactThreshold) : threshold(compactThreshold) {}
+
+BudgetStore::~BudgetStore() {
+    if (compactor.joinable()) compactor.join();
+}
+
+// Reads "YYYY-MM,amount" lines. Later lines replace earlier ones for the same month.
+bool BudgetStore::load(const std::string& budgetPath) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    path = budgetPath;
+    budgets.clear();
+    superseded = 0;
+    coveredBytes = 0;
+
+    if (!std::ifstream(path)) return false;
+    readTail();
+    return true;
+}
+
+// Applies one "YYYY-MM,amount" line. Replaced and unreadable lines both count as superseded.
+bool BudgetStore::applyLine(const std::string& line) {
+    size_t comma = line.find(',');
+    int32_t month = 0;
+    Money amount;
+    if (comma == std::string::npos || !packMonth(std::string_view(line).substr(0, comma), month) ||
+        !Money::parse(std::string_view(line).substr(comma + 1), amount)) {
+        ++superseded; // unreadable lines are dropped by the next compaction too
+        return false;
+    }
+
+    auto inserted = budgets.insert({month, amount});
+    if (!inserted.second) {
+        inserted.first->second = amount;
+        ++superseded;
+    }
+    return true;
+}
+
+// Reads the complete lines past coveredBytes in file order, so lines other
+// programs appended are merged in and the newest line for a month still wins.
+// Our own appends come round again here, which only sets the same value twice.
+// If the file shrank it was rewritten elsewhere and is read from the start.
+// False if it cannot be read or ends in a line that is still being written.
+bool BudgetStore::readTail() {
+    std::ifstream inFile(path, std::ios::binary);
+    if (!inFile || !inFile.seekg(0, std::ios::end)) return false;
+    size_t fileSize = static_cast<size_t>(inFile.tellg());
+    if (fileSize < coveredBytes) {
+        budgets.clear();
+        superseded = 0;
+        coveredBytes = 0;
+    }
+
+    std::string tail(fileSize - coveredBytes, '\0');
+    inFile.seekg(static_cast<std::streamoff>(coveredBytes));
+    inFile.read(&tail[0], static_cast<std::streamsize>(tail.size()));
+    if (static_cast<size_t>(inFile.gcount()) != tail.size()) return false;
+
+    size_t start = 0;
+    for (size_t end = tail.find('\n'); end != std::string::npos; end = tail.find('\n', start)) {
+        std::string line = tail.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) applyLine(line);
+        start = end + 1;
+    }
+    coveredBytes += start;
+    return start == tail.size();
+}
+
+bool BudgetStore::set(const std::string& month, Money amount) {
+    int32_t key = 0;
+    if (!packMonth(month, key)) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        std::ofstream outFile(path, std::ios::app); // append
+        if (!outFile) return false;
+        outFile << month << "," << amount << "\n";
+        outFile.close();
+
+        auto inserted = budgets.insert({key, amount});
+        if (!inserted.second) {
+            inserted.first->second = amount;
+            ++superseded;
+        }
+    }
+
+    maybeCompactInBackground();
+    return true;
+}
+
+Money BudgetStore::get(const std::string& month) const {
+    int32_t key = 0;
+    if (!packMonth(month, key)) return Money();
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    auto it = budgets.find(key);
+    return it == budgets.end() ? Money() : it->second;
+}
+
+bool BudgetStore::has(const std::string& month) const {
+    int32_t key = 0;
+    if (!packMonth(month, key)) return false;
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return budgets.count(key) > 0;
+}
+
+size_t BudgetStore::size() const {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return budgets.size();
+}
+
+size_t BudgetStore::supersededLines() const {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return superseded;
+}
+
+std::vector<std::pair<int32_t, Money>> BudgetStore::sorted() const {
+    std::vector<std::pair<int32_t, Money>> result;
+    {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        result.assign(budgets.begin(), budgets.end());
+    }
+    std::sort(result.begin(), result.end(),
+              [](const std::pair<int32_t, Money>& a, const std::pair<int32_t, Money>& b) { return a.first < b.first; });
+    return result;
+}
+
+void BudgetStore::compactNow() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    writeCompacted();
+}
+
+std::string BudgetStore::takeNotes() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::string taken;
+    taken.swap(notes);
+    return taken;
+}
+
+// Starts one background rewrite once the threshold is passed; skipped while one is still running.
+void BudgetStore::maybeCompactInBackground() {
+    if (supersededLines() <= threshold || compacting.exchange(true)) return;
+
+    if (compactor.joinable()) compactor.join(); // the previous run has cleared compacting, so it is exiting
+    compactor = std::thread([this] {
+        {
+            std::lock_guard<std::mutex> lock(fileMutex);
+            if (superseded > threshold) writeCompacted();
+        }
+        compacting = false;
+    });
+}
+
+// One line per month, in month order. Holding fileMutex keeps our appends out
+// while the file is swapped; lines other programs appended are merged in first.
+// A half-written last line is left for a later run, since the rewrite would drop it.
+bool BudgetStore::writeCompacted() {
+    if (!readTail()) return false;
+
+    std::vector<std::pair<int32_t, Money>> rows(budgets.begin(), budgets.end());
+    std::sort(rows.begin(), rows.end(),
+              [](const std::pair<int32_t, Money>& a, const std::pair<int32_t, Money>& b) { return a.first < b.first; });
+
+    std::string contents;
+    for (const auto& row : rows) {
+        contents += unpackMonth(row.first);
+        contents += ',';
+        contents += row.second.toString();
+        contents += '\n';
+    }
+
+    if (!writeFileAtomically(path, contents)) {
+        notes += "Warning: Could not compact " + path + ".\n";
+        return false;
+    }
+    superseded = 0;
+    coveredBytes = contents.size();
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef BUDGETSTORE_H
+#define BUDGETSTORE_H
+#include "Money.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Monthly budgets, loaded once from budget.txt into a hash map keyed by packed month.
+// Setting a budget appends a line, and the newest line for a month wins.
+// Once enough lines have been superseded, the file is rewritten on a
+// background thread with one line per month, after picking up any lines
+// other programs appended since the load.
+class BudgetStore {
+public:
+    explicit BudgetStore(size_t compactThreshold = 32);
+    ~BudgetStore();                         // waits for a running compaction
+    BudgetStore(const BudgetStore&) = delete;
+    BudgetStore& operator=(const BudgetStore&) = delete;
+
+    bool load(const std::string& path);     // false if the file does not exist yet
+    bool set(const std::string& month, Money amount); // append and apply; false if the file cannot be written
+    Money get(const std::string& month) const;        // zero when no budget was set
+    bool has(const std::string& month) const;
+
+    size_t size() const;                    // months with a budget
+    size_t supersededLines() const;         // lines in the file that no longer count
+    std::vector<std::pair<int32_t, Money>> sorted() const; // (packed month, budget) in month order
+
+    void compactNow();                      // rewrite the file on this thread
+    std::string takeNotes();                // warnings from background compactions, for the main thread to print
+
+private:
+    void maybeCompactInBackground();
+    bool applyLine(const std::string& line); // false if the line is unreadable; caller holds fileMutex
+    bool readTail();                        // apply lines appended past coveredBytes; caller holds fileMutex
+    bool writeCompacted();                  // caller holds fileMutex
+
+    std::string path;
+    std::unordered_map<int32_t, Money> budgets; // keyed by packMonth()
+    size_t superseded = 0;
+    size_t coveredBytes = 0;                // bytes of the file applied to budgets
+    std::string notes;                      // guarded by fileMutex
+    size_t threshold;
+
+    mutable std::mutex fileMutex;           // guards budgets, superseded and the file itself
+    std::thread compactor;
+    std::atomic<bool> compacting{false};    // set while compactor is running
+};
+
+#endif
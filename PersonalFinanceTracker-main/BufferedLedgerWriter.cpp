@@ -0,0 +1,60 @@
+#include "BufferedLedgerWriter.h"
+#include "AtomicFile.h"
+#include "PackedDate.h"
+
+BufferedLedgerWriter::BufferedLedgerWriter(size_t bufferBytes) : limit(bufferBytes) {
+    buffer.reserve(limit + 128);
+}
+
+BufferedLedgerWriter::~BufferedLedgerWriter() {
+    close();
+}
+
+bool BufferedLedgerWriter::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "ab");
+    writeFailed = file == nullptr;
+    return file != nullptr;
+}
+
+void BufferedLedgerWriter::formatLine(const Transaction& transaction, std::string& out) {
+    out += unpackDate(transaction.getDate());
+    out += ',';
+    out += transaction.getTypeName();
+    out += ',';
+    out += transaction.getCategory();
+    out += ',';
+    out += transaction.getAmount().toString();
+    out += '\n';
+}
+
+void BufferedLedgerWriter::append(const Transaction& transaction) {
+    formatLine(transaction, buffer);
+    if (buffer.size() >= limit) writeBuffer();
+}
+
+bool BufferedLedgerWriter::writeBuffer() {
+    if (!file) return false;
+    if (!buffer.empty()) {
+        if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) writeFailed = true;
+        written += buffer.size();
+        buffer.clear();
+    }
+    return !writeFailed;
+}
+
+bool BufferedLedgerWriter::commit() {
+    if (!file) return false;
+    writeBuffer();
+    if (!syncFile(file)) writeFailed = true;
+    ++commitCount;
+    return !writeFailed;
+}
+
+bool BufferedLedgerWriter::close() {
+    if (!file) return !writeFailed;
+    if (!buffer.empty()) commit();
+    if (std::fclose(file) != 0) writeFailed = true;
+    file = nullptr;
+    return !writeFailed;
+}
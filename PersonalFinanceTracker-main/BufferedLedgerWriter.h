@@ -0,0 +1,42 @@
+#ifndef BUFFEREDLEDGERWRITER_H
+#define BUFFEREDLEDGERWRITER_H
+#include "Transaction.h"
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+// Appends transactions to the text ledger through a large in-memory buffer.
+// Rows are formatted into the buffer and written out in big blocks; commit()
+// writes what is left and syncs the file, so a whole batch becomes durable
+// with one fsync instead of one open/write/close per row.
+class BufferedLedgerWriter {
+public:
+    explicit BufferedLedgerWriter(size_t bufferBytes = 1 << 20);
+    ~BufferedLedgerWriter();            // commits anything still buffered
+    BufferedLedgerWriter(const BufferedLedgerWriter&) = delete;
+    BufferedLedgerWriter& operator=(const BufferedLedgerWriter&) = delete;
+
+    bool open(const std::string& path); // append mode, creates the file if needed
+    void append(const Transaction& transaction);
+    bool commit();                      // write the buffer and sync: end of one group
+    bool close();
+
+    size_t bytesWritten() const { return written; }
+    size_t commits() const { return commitCount; }
+    bool failed() const { return writeFailed; }
+
+    // One ledger line, "date,type,category,amount\n".
+    static void formatLine(const Transaction& transaction, std::string& out);
+
+private:
+    bool writeBuffer();
+
+    std::FILE* file = nullptr;
+    std::string buffer;
+    size_t limit;
+    size_t written = 0;
+    size_t commitCount = 0;
+    bool writeFailed = false;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "CategoryIndex.h"
+#include <algorithm>
+#include <iterator>
+
+RowSet unionRows(const RowSet& a, const RowSet& b) {
+    RowSet result;
+    result.reserve(a.size() + b.size());
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+RowSet intersectRows(const RowSet& a, const RowSet& b) {
+    RowSet result;
+    result.reserve(std::min(a.size(), b.size()));
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+void CategoryIndex::rebuild(const std::vector<uint16_t>& categories, const std::vector<uint8_t>& live) {
+    postings.clear();
+    for (size_t row = 0; row < categories.size(); ++row) {
+        if (live[row]) add(static_cast<uint32_t>(row), categories[row]);
+    }
+}
+
+void CategoryIndex::add(uint32_t row, uint16_t category) {
+    if (category >= postings.size()) postings.resize(category + 1u);
+    RowSet& list = postings[category];
+    if (list.empty() || row > list.back()) list.push_back(row);
+    else list.insert(std::lower_bound(list.begin(), list.end(), row), row);
+}
+
+void CategoryIndex::remove(uint32_t row, uint16_t category) {
+    if (category >= postings.size()) return;
+    RowSet& list = postings[category];
+    auto pos = std::lower_bound(list.begin(), list.end(), row);
+    if (pos != list.end() && *pos == row) list.erase(pos);
+}
+
+void CategoryIndex::clear() {
+    postings.clear();
+}
+
+const RowSet& CategoryIndex::rows(uint16_t category) const {
+    static const RowSet empty;
+    if (category >= postings.size()) return empty;
+    return postings[category];
+}
+
+// Merges the posting lists pairwise; cost is proportional to the rows returned.
+RowSet CategoryIndex::rowsInAny(const std::vector<uint16_t>& categories) const {
+    RowSet result;
+    for (uint16_t category : categories) {
+        result = result.empty() ? rows(category) : unionRows(result, rows(category));
+    }
+    return result;
+}
@@ -0,0 +1,31 @@
+#ifndef CATEGORYINDEX_H
+#define CATEGORYINDEX_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sorted list of row ids. Posting lists and filter results share this form so
+// they can be combined without going back to the ledger.
+using RowSet = std::vector<uint32_t>;
+
+RowSet unionRows(const RowSet& a, const RowSet& b);     // rows in a or b
+RowSet intersectRows(const RowSet& a, const RowSet& b); // rows in both
+
+// Inverted index from category id to the live rows in that category. Rows are
+// almost always appended with increasing ids, so each posting list stays sorted
+// with a push_back; only an edited row moving category needs an insert.
+class CategoryIndex {
+public:
+    void rebuild(const std::vector<uint16_t>& categories, const std::vector<uint8_t>& live); // index a freshly loaded store
+    void add(uint32_t row, uint16_t category);              // keep up with an appended (or edited) row
+    void remove(uint32_t row, uint16_t category);           // drop a deleted row, or an edited one before add()
+    void clear();
+
+    const RowSet& rows(uint16_t category) const;           // empty if the category has no rows
+    RowSet rowsInAny(const std::vector<uint16_t>& categories) const; // union of several categories
+
+private:
+    std::vector<RowSet> postings; // indexed by CategoryPool id
+};
+
+#endif
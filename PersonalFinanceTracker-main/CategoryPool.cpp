@@ -0,0 +1,79 @@
+#include "CategoryPool.h"
+#include "CategoryRegistry.h"
+#include <mutex>
+#include <utility>
+
+// Takes the predefined categories first, so their pool ids match their registry ids.
+CategoryPool::CategoryPool() {
+    for (const CategoryInfo& category : CATEGORIES) {
+        names.emplace_back(category.name);
+        ids.emplace(names.back(), static_cast<uint16_t>(names.size() - 1));
+    }
+}
+
+CategoryPool& CategoryPool::instance() {
+    static CategoryPool pool;
+    return pool;
+}
+
+uint16_t CategoryPool::intern(std::string_view name) {
+    uint16_t known = 0;
+    if (CategoryRegistry::find(name, known)) return known;
+    CategoryPool& pool = instance();
+    {
+        std::shared_lock<std::shared_mutex> lock(pool.mutex);
+        auto it = pool.ids.find(name);
+        if (it != pool.ids.end()) return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(pool.mutex);
+    auto it = pool.ids.find(name); // another thread may have added it meanwhile
+    if (it != pool.ids.end()) return it->second;
+    uint16_t id = static_cast<uint16_t>(pool.names.size());
+    pool.names.emplace_back(name);
+    pool.ids.emplace(pool.names.back(), id);
+    return id;
+}
+
+uint16_t CategoryPool::intern(std::string&& name) {
+    uint16_t known = 0;
+    if (CategoryRegistry::find(name, known)) return known;
+    CategoryPool& pool = instance();
+    {
+        std::shared_lock<std::shared_mutex> lock(pool.mutex);
+        auto it = pool.ids.find(name);
+        if (it != pool.ids.end()) return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(pool.mutex);
+    auto it = pool.ids.find(name);
+    if (it != pool.ids.end()) return it->second;
+    uint16_t id = static_cast<uint16_t>(pool.names.size());
+    pool.names.push_back(std::move(name));
+    pool.ids.emplace(pool.names.back(), id);
+    return id;
+}
+
+std::string_view CategoryPool::name(uint16_t id) {
+    if (CategoryRegistry::contains(id)) return CategoryRegistry::name(id);
+    CategoryPool& pool = instance();
+    std::shared_lock<std::shared_mutex> lock(pool.mutex);
+    if (id >= pool.names.size()) return std::string_view();
+    return pool.names[id];
+}
+
+bool CategoryPool::find(std::string_view name, uint16_t& id) {
+    if (CategoryRegistry::find(name, id)) return true;
+    CategoryPool& pool = instance();
+    std::shared_lock<std::shared_mutex> lock(pool.mutex);
+    auto it = pool.ids.find(name);
+    if (it == pool.ids.end()) return false;
+    id = it->second;
+    return true;
+}
+
+size_t CategoryPool::size() {
+    CategoryPool& pool = instance();
+    std::shared_lock<std::shared_mutex> lock(pool.mutex);
+    return pool.names.size();
+}
@@ -0,0 +1,32 @@
+#ifndef CATEGORYPOOL_H
+#define CATEGORYPOOL_H
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Interns category names so each transaction only carries a small id.
+// The predefined categories keep their CategoryRegistry ids and are found without
+// a lock; other names get the following ids in first-seen order. Ids never change
+// while the program runs.
+// Safe to use from several threads: the ledger loads in the background while the menu interns and looks up names.
+class CategoryPool {
+public:
+    static uint16_t intern(std::string_view name);  // id for name, adding it if new
+    static uint16_t intern(std::string&& name);     // same, moving the string in when new
+    static std::string_view name(uint16_t id);      // name for id ("" if unknown)
+    static bool find(std::string_view name, uint16_t& id); // lookup without adding
+    static size_t size();
+
+private:
+    CategoryPool();
+    static CategoryPool& instance();
+
+    std::deque<std::string> names;                        // deque keeps the strings in place
+    std::unordered_map<std::string_view, uint16_t> ids;   // views point into names
+    mutable std::shared_mutex mutex;                      // writers only when a new name is added
+};
+
+#endif
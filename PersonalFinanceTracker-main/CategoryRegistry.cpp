@@ -0,0 +1,13 @@
+#include "CategoryRegistry.h"
+
+std::vector<std::string> CategoryRegistry::names(TransactionType type) {
+    std::vector<std::string> list;
+    if (type == TransactionType::Income) {
+        for (uint16_t id : INCOME_MENU) list.emplace_back(CATEGORIES[id].name);
+    } else {
+        for (const CategoryInfo& category : CATEGORIES) {
+            if (category.expense) list.emplace_back(category.name);
+        }
+    }
+    return list;
+}
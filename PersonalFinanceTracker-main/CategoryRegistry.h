@@ -0,0 +1,117 @@
+#ifndef CATEGORYREGISTRY_H
+#define CATEGORYREGISTRY_H
+#include "Transaction.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One predefined category. Its id is its position in CATEGORIES.
+struct CategoryInfo {
+    std::string_view name;  // as shown in menus and written to the ledger
+    bool expense;           // may be used for expenses
+    bool income;            // may be used for income
+};
+
+// Every predefined category, each listed once (Gifts is both kinds). Expense
+// menus list them in this order. Add new ones at the end so ids stay put.
+constexpr CategoryInfo CATEGORIES[] = {
+    {"Bills", true, false},         {"Charity", true, false},   {"Eating Out", true, false},
+    {"Entertainment", true, false}, {"Expenses", true, false},  {"Family", true, false},
+    {"Finances", true, false},      {"General", true, false},   {"Gifts", true, true},
+    {"Groceries", true, false},     {"Holidays", true, false},  {"Personal Care", true, false},
+    {"Savings", true, false},       {"Shopping", true, false},  {"Transfers", true, false},
+    {"Transport", true, false},     {"Salary", false, true},    {"Freelance", false, true},
+    {"Investments", false, true},   {"Other", false, true}
+};
+
+constexpr size_t CATEGORY_SLOTS = 64; // perfect hash table size, a power of two above 2x the categories
+
+// FNV-1a with the seed folded into the starting value.
+constexpr uint32_t categoryHash(std::string_view name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// First seed for which every category lands in its own slot (UINT32_MAX if none is found).
+constexpr uint32_t findCategorySeed() {
+    for (uint32_t seed = 0; seed < 100000; ++seed) {
+        bool used[CATEGORY_SLOTS] = {};
+        bool collision = false;
+        for (const CategoryInfo& category : CATEGORIES) {
+            size_t slot = categoryHash(category.name, seed) % CATEGORY_SLOTS;
+            if (used[slot]) {
+                collision = true;
+                break;
+            }
+            used[slot] = true;
+        }
+        if (!collision) return seed;
+    }
+    return UINT32_MAX;
+}
+
+// Slot -> id + 1, or 0 for an empty slot.
+constexpr std::array<uint8_t, CATEGORY_SLOTS> buildCategorySlots(uint32_t seed) {
+    std::array<uint8_t, CATEGORY_SLOTS> slots = {};
+    for (size_t id = 0; id < std::size(CATEGORIES); ++id) {
+        slots[categoryHash(CATEGORIES[id].name, seed) % CATEGORY_SLOTS] = static_cast<uint8_t>(id + 1);
+    }
+    return slots;
+}
+
+// Id of a name that is in CATEGORIES, for building tables at compile time.
+constexpr uint16_t categoryIdOf(std::string_view name) {
+    for (size_t id = 0; id < std::size(CATEGORIES); ++id) {
+        if (CATEGORIES[id].name == name) return static_cast<uint16_t>(id);
+    }
+    return UINT16_MAX;
+}
+
+// The predefined categories, fixed at compile time. CategoryPool hands out the
+// same ids, so per-category tables can be flat arrays indexed by id. Looking a
+// name up costs one hash, one slot and one compare, and needs no lock.
+class CategoryRegistry {
+public:
+    static constexpr size_t COUNT = std::size(CATEGORIES);
+
+    // Id for a predefined name; false for anything else.
+    static constexpr bool find(std::string_view name, uint16_t& id) {
+        uint8_t slot = SLOTS[categoryHash(name, SEED) % CATEGORY_SLOTS];
+        if (slot == 0 || CATEGORIES[slot - 1].name != name) return false;
+        id = static_cast<uint16_t>(slot - 1);
+        return true;
+    }
+
+    static constexpr bool contains(uint16_t id) { return id < COUNT; }
+    static constexpr std::string_view name(uint16_t id) { return id < COUNT ? CATEGORIES[id].name : std::string_view(); }
+
+    // Whether the category with this id is offered for type.
+    static constexpr bool allows(uint16_t id, TransactionType type) {
+        return id < COUNT && (type == TransactionType::Income ? CATEGORIES[id].income : CATEGORIES[id].expense);
+    }
+
+    // Names offered for type, in menu order.
+    static std::vector<std::string> names(TransactionType type);
+
+private:
+    static constexpr uint32_t SEED = findCategorySeed();
+    static constexpr std::array<uint8_t, CATEGORY_SLOTS> SLOTS = buildCategorySlots(SEED);
+};
+
+static_assert(CategoryRegistry::COUNT < CATEGORY_SLOTS / 2, "CATEGORY_SLOTS is too small for CATEGORIES");
+static_assert(findCategorySeed() != UINT32_MAX, "No perfect hash seed found for CATEGORIES");
+
+// Income menus keep the order the program has always shown.
+constexpr uint16_t INCOME_MENU[] = {
+    categoryIdOf("Salary"), categoryIdOf("Freelance"), categoryIdOf("Investments"),
+    categoryIdOf("Gifts"), categoryIdOf("Other")
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "DateIndex.h"
+#include <algorithm>
+
+// Stable sort keeps rows that share a date in the order they were loaded.
+void DateIndex::rebuild(const std::vector<int32_t>& dates, const std::vector<uint8_t>& live) {
+    rows.clear();
+    rows.reserve(dates.size());
+    for (size_t row = 0; row < dates.size(); ++row) {
+        if (live[row]) rows.push_back(static_cast<uint32_t>(row));
+    }
+    std::stable_sort(rows.begin(), rows.end(), [&dates](uint32_t a, uint32_t b) {
+        return dates[a] < dates[b];
+    });
+
+    sortedDates.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        sortedDates[i] = dates[rows[i]];
+    }
+}
+
+// In-order appends are a push_back. Otherwise the row goes among the rows on
+// the same day by id, which for a new row is after all of them.
+void DateIndex::add(uint32_t row, int32_t date) {
+    if (sortedDates.empty() || (date > sortedDates.back() || (date == sortedDates.back() && row > rows.back()))) {
+        sortedDates.push_back(date);
+        rows.push_back(row);
+        return;
+    }
+
+    auto first = std::lower_bound(sortedDates.begin(), sortedDates.end(), date);
+    auto last = std::upper_bound(first, sortedDates.end(), date);
+    size_t begin = static_cast<size_t>(first - sortedDates.begin());
+    size_t end = static_cast<size_t>(last - sortedDates.begin());
+    auto pos = std::upper_bound(rows.begin() + static_cast<std::ptrdiff_t>(begin),
+                                rows.begin() + static_cast<std::ptrdiff_t>(end), row);
+    size_t offset = static_cast<size_t>(pos - rows.begin());
+    sortedDates.insert(sortedDates.begin() + static_cast<std::ptrdiff_t>(offset), date);
+    rows.insert(pos, row);
+}
+
+// The row is found by binary search on its date, then by id within the day.
+void DateIndex::remove(uint32_t row, int32_t date) {
+    Range day = on(date);
+    const uint32_t* pos = std::lower_bound(day.begin, day.end, row);
+    if (pos == day.end || *pos != row) return;
+    size_t offset = static_cast<size_t>(pos - rows.data());
+    sortedDates.erase(sortedDates.begin() + static_cast<std::ptrdiff_t>(offset));
+    rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(offset));
+}
+
+// Sorts the new rows on their own and merges them in with one linear pass,
+// instead of one insert (and shift) per row.
+void DateIndex::addBatch(uint32_t firstRow, const int32_t* dates, size_t count) {
+    std::vector<uint32_t> batch(count);
+    for (size_t i = 0; i < count; ++i) batch[i] = firstRow + static_cast<uint32_t>(i);
+    std::stable_sort(batch.begin(), batch.end(), [&](uint32_t a, uint32_t b) {
+        return dates[a - firstRow] < dates[b - firstRow];
+    });
+
+    std::vector<int32_t> mergedDates;
+    std::vector<uint32_t> mergedRows;
+    mergedDates.reserve(sortedDates.size() + count);
+    mergedRows.reserve(rows.size() + count);
+
+    // Existing rows come first on equal dates: the new rows are later in the file.
+    size_t i = 0, j = 0;
+    while (i < sortedDates.size() || j < count) {
+        if (j == count || (i < sortedDates.size() && sortedDates[i] <= dates[batch[j] - firstRow])) {
+            mergedDates.push_back(sortedDates[i]);
+            mergedRows.push_back(rows[i]);
+            ++i;
+        } else {
+            mergedDates.push_back(dates[batch[j] - firstRow]);
+            mergedRows.push_back(batch[j]);
+            ++j;
+        }
+    }
+
+    sortedDates.swap(mergedDates);
+    rows.swap(mergedRows);
+}
+
+bool DateIndex::restore(const std::vector<int32_t>& dates, const std::vector<uint8_t>& live,
+                        std::vector<uint32_t> order) {
+    clear();
+    if (live.size() != dates.size() ||
+        order.size() != static_cast<size_t>(std::count(live.begin(), live.end(), 1))) return false;
+
+    std::vector<int32_t> restored(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i] >= dates.size() || !live[order[i]]) return false;
+        restored[i] = dates[order[i]];
+        if (i > 0 && restored[i] < restored[i - 1]) return false;
+    }
+
+    sortedDates.swap(restored);
+    rows.swap(order);
+    return true;
+}
+
+void DateIndex::clear() {
+    sortedDates.clear();
+    rows.clear();
+}
+
+DateIndex::Range DateIndex::on(int32_t date) const {
+    return between(date, date);
+}
+
+DateIndex::Range DateIndex::between(int32_t from, int32_t to) const {
+    if (from > to) return Range{rows.data(), rows.data()};
+
+    auto first = std::lower_bound(sortedDates.begin(), sortedDates.end(), from);
+    auto last = std::upper_bound(first, sortedDates.end(), to);
+    const uint32_t* base = rows.data();
+    return Range{base + (first - sortedDates.begin()), base + (last - sortedDates.begin())};
+}
@@ -0,0 +1,40 @@
+#ifndef DATEINDEX_H
+#define DATEINDEX_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Row ids of the store ordered by date, so a day or a range of days is found
+// with a binary search. Rows with the same date stay in id order. Dead rows
+// (see TransactionStore) are left out.
+class DateIndex {
+public:
+    // Half-open slice [begin, end) of row ids.
+    struct Range {
+        const uint32_t* begin;
+        const uint32_t* end;
+        size_t size() const { return static_cast<size_t>(end - begin); }
+        bool empty() const { return begin == end; }
+    };
+
+    void rebuild(const std::vector<int32_t>& dates, const std::vector<uint8_t>& live); // sort the live rows of a freshly loaded store
+    void add(uint32_t row, int32_t date);            // keep order when a row is appended (or edited), even out of order
+    void remove(uint32_t row, int32_t date);         // drop a deleted row, or an edited one before add() puts it back
+    void addBatch(uint32_t firstRow, const int32_t* dates, size_t count); // rows firstRow.. appended together
+    void clear();
+
+    // The row order itself, for saving, and restoring it without sorting again.
+    // restore() returns false (and leaves the index empty) if order is not the live rows sorted by date.
+    const std::vector<uint32_t>& order() const { return rows; }
+    bool restore(const std::vector<int32_t>& dates, const std::vector<uint8_t>& live, std::vector<uint32_t> order);
+
+    Range on(int32_t date) const;                    // rows on one packed date
+    Range between(int32_t from, int32_t to) const;   // rows with from <= date <= to
+    size_t size() const { return rows.size(); }
+
+private:
+    std::vector<int32_t> sortedDates; // sortedDates[i] is the date of rows[i]
+    std::vector<uint32_t> rows;
+};
+
+#endif
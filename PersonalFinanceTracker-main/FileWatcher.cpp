@@ -0,0 +1,83 @@
+#include "FileWatcher.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher() {
+#ifdef __linux__
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (fd >= 0) ::close(fd);
+#endif
+}
+
+void FileWatcher::add(const std::string& path) {
+    std::filesystem::path p(path);
+    Watched file;
+    file.path = path;
+    file.name = p.filename().string();
+    stamp(file);
+
+#ifdef __linux__
+    if (fd >= 0) {
+        std::string directory = p.has_parent_path() ? p.parent_path().string() : ".";
+        // Watching a directory twice returns the same descriptor, so files can share it.
+        file.directory = inotify_add_watch(fd, directory.c_str(),
+                                           IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                                           IN_MOVED_TO | IN_MOVED_FROM);
+    }
+#endif
+    files.push_back(std::move(file));
+}
+
+// Size and modification time of file, compared with the previous call.
+bool FileWatcher::stamp(Watched& file) {
+    std::error_code sizeError, timeError;
+    uintmax_t size = std::filesystem::file_size(file.path, sizeError);
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(file.path, timeError);
+    if (sizeError) size = 0;
+    if (timeError) time = std::filesystem::file_time_type();
+
+    bool moved = size != file.size || time != file.time;
+    file.size = size;
+    file.time = time;
+    return moved;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+#ifdef __linux__
+    if (fd >= 0) {
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            ssize_t length = ::read(fd, buffer, sizeof(buffer));
+            if (length <= 0) break; // EAGAIN: nothing more queued
+
+            for (char* p = buffer; p < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                for (Watched& file : files) {
+                    // A full queue loses events, so every file has to be checked again.
+                    if ((event->mask & IN_Q_OVERFLOW) ||
+                        (event->wd == file.directory && event->len > 0 && file.name == event->name)) {
+                        file.changed = true;
+                    }
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+#endif
+
+    std::vector<std::string> changed;
+    for (Watched& file : files) {
+        if (file.directory < 0 && stamp(file)) file.changed = true;
+        if (file.changed) changed.push_back(file.path);
+        file.changed = false;
+    }
+    return changed;
+}
@@ -0,0 +1,38 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Tells which of a few files have changed since the last poll, without blocking.
+// On Linux this is inotify on each file's directory, so a file replaced by a
+// rename is noticed as well as one written in place. Elsewhere (or if inotify
+// is unavailable) every poll compares size and modification time instead.
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    void add(const std::string& path);  // start watching; the file need not exist yet
+    std::vector<std::string> poll();    // paths changed since the last poll, each once
+
+private:
+    struct Watched {
+        std::string path;
+        std::string name;               // file name within its directory
+        int directory = -1;             // inotify watch on the directory
+        bool changed = false;
+        uintmax_t size = 0;             // polling fallback: what the last poll saw
+        std::filesystem::file_time_type time;
+    };
+
+    bool stamp(Watched& file);          // fallback: refresh size/time, true if they moved
+
+    std::vector<Watched> files;
+    int fd = -1;                        // inotify instance, -1 when polling
+};
+
+#endif
@@ -1,336 +1,1383 @@
 #include "FinanceManager.h"
+#include "AtomicFile.h"
+#include "BinaryLedger.h"
+#include "BufferedLedgerWriter.h"
+#include "CategoryPool.h"
+#include "CategoryRegistry.h"
+#include "LedgerParser.h"
+#include "LedgerSnapshot.h"
+#include "MappedFile.h"
+#include "PackedDate.h"
+#include "ParallelScanner.h"
+#include "Profiler.h"
+#include "ResultWriter.h"
+#include "SegmentedLedger.h"
+#include "Validation.h"
+#include <algorithm>  // std::sort
+#include <chrono>     // import timing
+#include <filesystem> // ledger size
 #include <fstream>    // file I/O
+#include <iomanip>    // report columns
 #include <iostream>   // console output
-#include <sstream>    // parsing
+#include <sstream>    // load messages
 #include <vector>
 #include <map>
 
-// Saves a transaction to "data/transactions.txt"
-void FinanceManager::saveTransactionToFile(const Transaction& transaction) {
-    std::ofstream outFile("data/transactions.txt", std::ios::app);
-    if (!outFile) {
-        std::cout << "Error: Could not open file to save transaction.\n";
+static const char* LEDGER_PATH = "data/transactions.txt";
+static const char* BINARY_LEDGER_PATH = "data/transactions.bin";
+static const char* BUDGET_PATH = "data/budget.txt";
+static const char* SNAPSHOT_PATH = "data/snapshot.bin";
+
+// Starts the load on a background thread so the menu is usable at once.
+// With --stats it runs in the foreground instead, so its timings are not spread over the first query.
+FinanceManager::FinanceManager(LedgerFormat ledgerFormat, unsigned loadThreads, bool useSnapshot)
+    : format(ledgerFormat), threads(loadThreads) {
+    if (Profiler::enabled()) {
+        loadLedger(useSnapshot);
+        waitFor(LoadStage::Ready);
         return;
     }
+    loader = std::thread([this, useSnapshot] { loadLedger(useSnapshot); });
+}
+
+FinanceManager::~FinanceManager() {
+    if (loader.joinable()) loader.join();
+}
 
-    outFile << transaction.getDate() << ","
-            << transaction.getType() << ","
-            << transaction.getCategory() << ","
-            << transaction.getAmount() << "\n";
+// Loads the ledger once; every query after this runs against memory.
+// Budgets come first since they are tiny, then the rows and totals, then the indexes.
+// A segmented ledger only reads its manifest here, and segments are loaded when first needed.
+// With useSnapshot a text ledger starts from data/snapshot.bin and parses only what was appended since.
+// Messages go to notes and are printed by the main thread, so they never land in the middle of a prompt.
+void FinanceManager::loadLedger(bool useSnapshot) {
+    ScopedTimer timer("load");
+    // Watch before reading, so anything appended while the load runs is noticed afterwards.
+    if (format == LedgerFormat::Text) watcher.add(LEDGER_PATH);
+    watcher.add(BUDGET_PATH);
+    {
+        ScopedTimer budgetTimer("load.budgets");
+        budgets.load(BUDGET_PATH);
+    }
+    finishStage(LoadStage::Budgets, "");
+
+    std::ostringstream notes;
+    bool restored = false;
+    if (format == LedgerFormat::Segmented) {
+        std::vector<ParseError> skipped;
+        segments.open(skipped);
+        for (const ParseError& e : skipped) {
+            notes << "Skipping invalid line " << e.lineNumber << " of the segment manifest (" << e.message
+                  << "): " << e.text << "\n";
+        }
+        historyLoaded = false;
+    } else if (format == LedgerFormat::Binary) {
+        ScopedTimer parseTimer("load.parse");
+        std::string error;
+        if (!store.loadFromBinaryFile(BINARY_LEDGER_PATH, error) && !error.empty()) notes << "Error: " << error << "\n";
+        for (size_t i = 0; i < store.size(); ++i) {
+            aggregates.add(store.at(i));
+        }
+    } else if (useSnapshot && loadFromSnapshot(notes)) {
+        restored = true;
+    } else {
+        ParallelScanner(threads).load(LEDGER_PATH, store, aggregates);
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(LEDGER_PATH, ec);
+        coveredBytes = ec ? 0 : static_cast<size_t>(size);
+    }
+    if (format == LedgerFormat::Text) rememberLedgerPrefix();
+    if (!restored) {
+        Profiler::count(Profiler::Counter::RowsParsed, store.size() + store.loadErrors().size());
+        Profiler::count(Profiler::Counter::ParseErrors, store.loadErrors().size());
+    }
+    store.printLoadErrors(notes);
+    {
+        ScopedTimer spendingTimer("load.spending");
+        spending.rebuild(store, threads);
+    }
+    finishStage(LoadStage::Totals, notes.str());
 
-    outFile.close();
-    std::cout << "Transaction saved to file.\n";
+    {
+        ScopedTimer indexTimer("load.indexes");
+        if (!restored) dateIndex.rebuild(store.dates(), store.live());
+        categoryIndex.rebuild(store.categories(), store.live());
+        timeline.rebuild(store);
+    }
+    finishStage(LoadStage::Ready, unknownCategoryNote());
 }
 
-// Loads and displays all transactions from the file
-void FinanceManager::loadTransactionsFromFile() {
-    std::ifstream inFile("data/transactions.txt");
-    if (!inFile) {
-        std::cout << "Error: Could not open transactions file.\n";
-        return;
+// Counts rows whose category is not a predefined one (hand edits, old files),
+// so they are reported instead of quietly missing from menus and charts.
+std::string FinanceManager::unknownCategoryNote() const {
+    size_t rows = 0;
+    std::string names;
+    for (size_t id = CategoryRegistry::COUNT; id < CategoryPool::size(); ++id) {
+        size_t count = categoryIndex.rows(static_cast<uint16_t>(id)).size();
+        if (count == 0) continue;
+        rows += count;
+        names += (names.empty() ? "" : ", ") + std::string(CategoryPool::name(static_cast<uint16_t>(id)));
+    }
+    if (rows == 0) return "";
+    return "Note: " + std::to_string(rows) + " transaction(s) use categories that are not predefined: " + names + ".\n";
+}
+
+// Marks stage as done and wakes every query waiting for it.
+void FinanceManager::finishStage(LoadStage stage, const std::string& notes) {
+    std::lock_guard<std::mutex> lock(loadMutex);
+    loadStage = stage;
+    loadNotes += notes;
+    loadChanged.notify_all();
+}
+
+// Blocks until the load has reached stage. After 100 ms a progress line shows
+// what is still being read; it is erased once the wait is over. Any messages
+// the load produced so far, and any warning from a background budget
+// compaction, are printed here, on the main thread. Once the load is done,
+// changes other programs made to the files are applied too.
+void FinanceManager::waitFor(LoadStage stage) {
+    std::unique_lock<std::mutex> lock(loadMutex);
+    if (loadStage < stage) {
+        auto start = std::chrono::steady_clock::now();
+        size_t shown = 0;
+        while (!loadChanged.wait_for(lock, std::chrono::milliseconds(100), [&] { return loadStage >= stage; })) {
+            const char* doing = loadStage == LoadStage::Starting ? "Loading budgets"
+                              : loadStage == LoadStage::Budgets  ? "Loading transactions" : "Building indexes";
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::ostringstream line;
+            line << doing << "... " << std::fixed << std::setprecision(1) << seconds << "s";
+            std::string text = line.str();
+            if (text.size() < shown) text += std::string(shown - text.size(), ' ');
+            std::cout << "\r" << text << std::flush;
+            shown = text.size();
+        }
+        if (shown > 0) std::cout << "\r" << std::string(shown, ' ') << "\r" << std::flush;
+    }
+    if (!loadNotes.empty()) {
+        std::cout << loadNotes;
+        loadNotes.clear();
+    }
+    std::cout << budgets.takeNotes();
+    if (loadStage == LoadStage::Ready && autoRefresh) {
+        lock.unlock();
+        applyExternalChanges(std::cout);
     }
+}
 
-    std::string line;
-    std::cout << "\nSaved Transactions:\n";
+// Up to length bytes of path from offset ("" if the file cannot be read).
+static std::string readRange(const char* path, size_t offset, size_t length) {
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes(length, '\0');
+    if (!in.seekg(static_cast<std::streamoff>(offset))) return std::string();
+    in.read(&bytes[0], static_cast<std::streamsize>(length));
+    bytes.resize(static_cast<size_t>(in.gcount()));
+    return bytes;
+}
+
+// Checksum of the first bytes of the ledger (false if it is missing or shorter).
+static bool checksumLedgerPrefix(size_t bytes, uint64_t& sum) {
+    if (bytes == 0) {
+        sum = LedgerSnapshot::checksum(nullptr, 0);
+        return true;
+    }
+    MappedFile ledger;
+    if (!ledger.open(LEDGER_PATH) || ledger.size() < bytes) return false;
+    sum = LedgerSnapshot::checksum(ledger.data(), bytes);
+    Profiler::count(Profiler::Counter::BytesRead, bytes);
+    return true;
+}
+
+// Checksums the covered ledger. A later change that leaves those bytes alone
+// and only makes the file longer is treated as an append; any edit inside
+// them, even one that keeps the size (12.50 -> 13.50), means a reload.
+void FinanceManager::rememberLedgerPrefix() {
+    uint64_t sum = 0;
+    coveredChecksum.reset();
+    if (checksumLedgerPrefix(coveredBytes, sum)) coveredChecksum = sum;
+}
+
+bool FinanceManager::ledgerPrefixMatches() const {
+    uint64_t sum = 0;
+    return coveredChecksum && checksumLedgerPrefix(coveredBytes, sum) && sum == *coveredChecksum;
+}
+
+// Applies what other programs (bank sync scripts, editors) did to the files
+// since the last operation. Appended ledger lines are parsed and added like an
+// import batch; a ledger that shrank or whose covered bytes changed is read
+// again from scratch. budget.txt is small and simply re-read.
+// Our own writes are reported too, and fall through as "nothing new"; so is
+// our own compaction, once its new offsets are adopted.
+void FinanceManager::applyExternalChanges(std::ostream& out) {
+    std::vector<std::string> changed = watcher.poll();
+    absorbCompaction(out);
+    for (const std::string& path : changed) {
+        if (path == BUDGET_PATH) {
+            budgets.load(BUDGET_PATH);
+            continue;
+        }
+
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(LEDGER_PATH, ec);
+        if (ec) continue; // gone for now (mid-rename); the next event brings it back
+        if ((size < coveredBytes || !ledgerPrefixMatches()) && compactor.running()) {
+            // Most likely the compaction swapping the file in just now.
+            compactor.wait();
+            absorbCompaction(out);
+            size = std::filesystem::file_size(LEDGER_PATH, ec);
+            if (ec) continue;
+        }
+        if (size < coveredBytes || !ledgerPrefixMatches()) {
+            reloadLedger(out);
+        } else if (size > coveredBytes) {
+            readAppendedLines(static_cast<size_t>(size), out);
+        }
+    }
+}
+
+// Parses the complete lines between coveredBytes and ledgerSize. A line still
+// being written (no newline yet) is left for the next change.
+void FinanceManager::readAppendedLines(size_t ledgerSize, std::ostream& out) {
+    ScopedTimer timer("refresh.append");
+    std::string bytes = readRange(LEDGER_PATH, coveredBytes, ledgerSize - coveredBytes);
+    if (coveredLines == SIZE_MAX) {
+        MappedFile ledger;
+        if (!ledger.open(LEDGER_PATH) || ledger.size() < coveredBytes) return;
+        coveredLines = static_cast<size_t>(std::count(ledger.data(), ledger.data() + coveredBytes, '\n'));
+    }
+
+    // Rows before a record have to be in the store before the record can name them.
+    std::vector<Transaction> batch;
+    std::vector<ParseError> errors = store.loadErrors();
+    size_t knownErrors = errors.size();
+    size_t added = 0, edits = 0;
+    size_t used = LedgerParser::parseBuffer(bytes.data(), bytes.size(), false, coveredLines,
+        [&](const LedgerRow& row) {
+            if (row.kind == LedgerRowKind::Transaction) {
+                batch.emplace_back(row.transactionType, row.amount, CategoryPool::intern(row.category), row.packedDate);
+                return;
+            }
+            recordBatch(batch);
+            added += batch.size();
+            batch.clear();
+            if (row.kind == LedgerRowKind::Gap) {
+                store.appendGap(row.target);
+            } else if (row.kind == LedgerRowKind::Unreadable) {
+                store.appendGap(1);
+            } else if (applyRecord(row)) {
+                ++edits;
+            } else {
+                errors.push_back({row.lineNumber, "no live transaction with id " + std::to_string(row.target),
+                                  std::string(row.text)});
+            }
+        }, errors);
+    if (used == 0) return;
+
+    for (size_t i = knownErrors; i < errors.size(); ++i) {
+        out << "Skipping invalid transaction on line " << errors[i].lineNumber
+                  << " (" << errors[i].message << "): " << errors[i].text << "\n";
+    }
+    Profiler::count(Profiler::Counter::BytesRead, used);
+    recordBatch(batch);
+    added += batch.size();
+    Profiler::count(Profiler::Counter::RowsParsed, added + edits + errors.size() - knownErrors);
+    Profiler::count(Profiler::Counter::ParseErrors, errors.size() - knownErrors);
+
+    store.finishLoad(std::move(errors));
+    coveredBytes += used;
+    snapshotCurrent = false;
+    rememberLedgerPrefix();
+    if (added > 0) out << "Picked up " << added << " new transactions from " << LEDGER_PATH << ".\n";
+    if (edits > 0) out << "Picked up " << edits << " edits and deletions from " << LEDGER_PATH << ".\n";
+}
+
+// The ledger was truncated or rewritten under us: load it again from scratch.
+void FinanceManager::reloadLedger(std::ostream& out) {
+    ScopedTimer timer("refresh.reload");
+    out << LEDGER_PATH << " was rewritten by another program, reloading it.\n";
+    compactor.wait();
+    compactor.takeResult(); // it was working on the old contents
+    ParallelScanner(threads).load(LEDGER_PATH, store, aggregates);
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(LEDGER_PATH, ec);
+    coveredBytes = ec ? 0 : static_cast<size_t>(size);
+    coveredLines = SIZE_MAX;
+    snapshotCurrent = false;
+    rememberLedgerPrefix();
+
+    Profiler::count(Profiler::Counter::RowsParsed, store.size() + store.loadErrors().size());
+    Profiler::count(Profiler::Counter::ParseErrors, store.loadErrors().size());
+    store.printLoadErrors(out);
+    spending.rebuild(store, threads);
+    dateIndex.rebuild(store.dates(), store.live());
+    categoryIndex.rebuild(store.categories(), store.live());
+    timeline.rebuild(store);
+}
+
+// Blocks until the whole ledger is in memory, including every segment of a segmented one.
+void FinanceManager::waitUntilLoaded() {
+    loadHistory();
+}
+
+// For callers that turned autoRefresh off (the daemon) and apply changes at times of their choosing.
+void FinanceManager::refresh(std::ostream& out) {
+    waitFor(LoadStage::Ready);
+    applyExternalChanges(out);
+}
+
+// Restores the rows and date order from the snapshot, then parses only the
+// lines appended to the ledger after it was written. False (nothing loaded)
+// if there is no snapshot or the ledger no longer starts with what it covered.
+bool FinanceManager::loadFromSnapshot(std::ostream& notes) {
+    ScopedTimer timer("load.snapshot");
+    MappedFile ledger;
+    if (!ledger.open(LEDGER_PATH)) return false;
+
+    size_t covered = 0, lineNumber = 0;
+    std::string reason;
+    if (!LedgerSnapshot::load(SNAPSHOT_PATH, ledger.data(), ledger.size(), store, dateIndex, aggregates,
+                              covered, lineNumber, reason)) {
+        if (reason != "no snapshot") notes << "Snapshot not used (" << reason << "), reading the whole ledger.\n";
+        return false;
+    }
+
+    // Only the store and totals exist at this point; the other indexes are built from the store later.
+    uint32_t firstRow = static_cast<uint32_t>(store.size());
+    std::vector<ParseError> errors = store.loadErrors();
+    size_t knownErrors = errors.size(), tailRows = 0;
+    bool records = false;
+    LedgerParser::parseBuffer(ledger.data() + covered, ledger.size() - covered, true, lineNumber,
+        [&](const LedgerRow& row) {
+            if (row.kind == LedgerRowKind::Unreadable) {
+                store.appendGap(1); // already counted with the errors
+                records = true;
+                return;
+            }
+            ++tailRows;
+            if (row.kind == LedgerRowKind::Gap) {
+                store.appendGap(row.target);
+            } else if (row.kind != LedgerRowKind::Transaction && !store.isLive(row.target)) {
+                errors.push_back({row.lineNumber, "no live transaction with id " + std::to_string(row.target),
+                                  std::string(row.text)});
+                return;
+            } else if (row.kind == LedgerRowKind::Delete) {
+                aggregates.remove(store.at(row.target));
+                store.remove(row.target);
+            } else {
+                Transaction transaction(row.transactionType, row.amount, CategoryPool::intern(row.category), row.packedDate);
+                if (row.kind == LedgerRowKind::Replace) {
+                    aggregates.remove(store.at(row.target));
+                    store.replace(row.target, transaction);
+                } else {
+                    store.append(transaction);
+                }
+                aggregates.add(transaction);
+            }
+            records = records || row.kind != LedgerRowKind::Transaction;
+        }, errors);
+    Profiler::count(Profiler::Counter::BytesRead, ledger.size() - covered);
+    Profiler::count(Profiler::Counter::RowsParsed, tailRows + errors.size() - knownErrors);
+    Profiler::count(Profiler::Counter::ParseErrors, errors.size() - knownErrors);
+
+    store.finishLoad(std::move(errors));
+    if (records) dateIndex.rebuild(store.dates(), store.live());
+    else dateIndex.addBatch(firstRow, store.dates().data() + firstRow, store.size() - firstRow);
+
+    coveredBytes = ledger.size();
+    coveredLines = lineNumber;
+    snapshotCurrent = covered == ledger.size();
+    return true;
+}
+
+// Writes data/snapshot.bin for the next start if the ledger changed since the last one.
+// A failure only costs the next start a full parse, so it is not reported.
+void FinanceManager::saveSnapshot() {
+    waitFor(LoadStage::Ready);
+    if (format != LedgerFormat::Text) return;
+    compactor.wait();
+    absorbCompaction(std::cout);
+    if (snapshotCurrent || !store.isLoaded() || !coveredChecksum) return;
+
+    ScopedTimer timer("saveSnapshot");
+    MappedFile ledger;
+    if (!ledger.open(LEDGER_PATH) || ledger.size() < coveredBytes) return;
+
+    std::string error;
+    snapshotCurrent = LedgerSnapshot::save(SNAPSHOT_PATH, ledger.data(), coveredBytes, store, dateIndex, aggregates, error);
+}
+
+// Waits for the background load to finish. A segmented ledger then reads every
+// segment the first time a query needs the whole history.
+void FinanceManager::loadHistory() {
+    waitFor(LoadStage::Ready);
+    if (historyLoaded) return;
+    historyLoaded = true;
+    loadedMonths.clear();
+
+    ScopedTimer timer("load.segments");
+    segments.loadAll(store);
+    aggregates.clear();
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (store.isLive(i)) aggregates.add(store.at(i));
+    }
+    Profiler::count(Profiler::Counter::RowsParsed, store.size() + store.loadErrors().size());
+    Profiler::count(Profiler::Counter::ParseErrors, store.loadErrors().size());
+    store.printLoadErrors();
+    spending.rebuild(store, threads);
+    dateIndex.rebuild(store.dates(), store.live());
+    categoryIndex.rebuild(store.categories(), store.live());
+    timeline.rebuild(store);
+}
+
+// Waits only until the month totals are loaded, not for the indexes. A segmented
+// ledger folds one month's segment into the totals, so a monthly question reads
+// one file instead of the history.
+void FinanceManager::loadMonth(const std::string& month) {
+    waitFor(LoadStage::Totals);
+    int32_t key = 0;
+    if (historyLoaded || !packMonth(month, key) || !loadedMonths.insert(key).second) return;
+
+    ScopedTimer timer("load.segment");
+    TransactionStore rows;
+    if (!segments.loadMonth(key, rows)) return;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        aggregates.add(rows.at(i));
+        spending.add(rows.at(i));
+    }
+    Profiler::count(Profiler::Counter::RowsParsed, rows.size() + rows.loadErrors().size());
+    Profiler::count(Profiler::Counter::ParseErrors, rows.loadErrors().size());
+    rows.printLoadErrors();
+}
+
+// Whether there is a ledger to report on (a segmented one may not be loaded yet).
+bool FinanceManager::ledgerAvailable() const {
+    return format == LedgerFormat::Segmented ? segments.exists() : store.isLoaded();
+}
+
+// Adds a saved transaction to the store and keeps the derived tables in step.
+void FinanceManager::recordTransaction(const Transaction& transaction) {
+    uint32_t row = static_cast<uint32_t>(store.size());
+    store.append(transaction);
+    aggregates.add(transaction);
+    dateIndex.add(row, transaction.getDate());
+    categoryIndex.add(row, transaction.getCategoryId());
+    timeline.add(transaction);
+    spending.add(transaction);
+}
 
-    while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        std::string date, type, category, amountStr;
+// Adds an imported batch: rows go to the store one by one, but the totals and
+// the date index are updated once for the whole batch.
+void FinanceManager::recordBatch(const std::vector<Transaction>& batch) {
+    uint32_t firstRow = static_cast<uint32_t>(store.size());
+    AggregateTable delta;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        store.append(batch[i]);
+        delta.add(batch[i]);
+        categoryIndex.add(firstRow + static_cast<uint32_t>(i), batch[i].getCategoryId());
+        timeline.add(batch[i]);
+        spending.add(batch[i]);
+    }
+    aggregates.merge(delta);
+    dateIndex.addBatch(firstRow, store.dates().data() + firstRow, batch.size());
+}
 
-        std::getline(ss, date, ',');
-        std::getline(ss, type, ',');
-        std::getline(ss, category, ',');
-        std::getline(ss, amountStr, ',');
+// Size of the text ledger, 0 if it does not exist yet.
+static size_t ledgerFileSize() {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(LEDGER_PATH, ec);
+    return ec ? 0 : static_cast<size_t>(size);
+}
 
-        double amount = std::stod(amountStr);
-        Transaction t(type, amount, category, date);
-        t.display();
+// Our appends must start exactly at coveredBytes, so complete lines other
+// programs appended since the last refresh are taken in first. False (with a
+// message) if the ledger shrank or ends in a line that is still being written.
+// Caller holds the compactor's file lock.
+bool FinanceManager::catchUpBeforeAppend(std::ostream& out) {
+    absorbCompaction(out);
+    if (!coveredChecksum) {
+        out << "Error: " << LEDGER_PATH << " was changed by another program, try again.\n";
+        return false;
     }
+    size_t size = ledgerFileSize();
+    if (size > coveredBytes) readAppendedLines(size, out);
+    if (size < coveredBytes) {
+        out << "Error: " << LEDGER_PATH << " was rewritten by another program, try again.\n";
+        return false;
+    }
+    if (size > coveredBytes) {
+        out << "Error: " << LEDGER_PATH << " ends in a line another program is still writing, try again.\n";
+        return false;
+    }
+    return true;
+}
 
-    inFile.close();
+// Moves coveredBytes past what we appended. If the file grew by anything else
+// meanwhile, coveredBytes may no longer end on our line, so the checksum is
+// dropped: until the next refresh reads the whole ledger again, nothing that
+// relies on coveredBytes (appends, compaction, the snapshot) runs.
+void FinanceManager::coverAppended(size_t bytes) {
+    size_t expected = coveredBytes + bytes;
+    coveredBytes = expected;
+    coveredLines = SIZE_MAX;
+    snapshotCurrent = false;
+    if (ledgerFileSize() == expected) rememberLedgerPrefix();
+    else coveredChecksum.reset();
 }
 
-// Sets a monthly budget for a specific month (e.g., "2025-04")
-void FinanceManager::setMonthlyBudget(const std::string& month, double amount) {
-    std::ofstream outFile("data/budget.txt", std::ios::app); // append
+// Appends to the text ledger. The compactor's lock keeps the line out of a file
+// that is about to be replaced; the line is copied into the new one instead.
+bool FinanceManager::appendToLedger(const std::string& lines, std::ostream& out) {
+    std::lock_guard<std::mutex> lock(compactor.fileMutex());
+    if (!catchUpBeforeAppend(out)) return false;
+    std::ofstream outFile(LEDGER_PATH, std::ios::app | std::ios::binary);
+    if (outFile) {
+        outFile << lines;
+        outFile.close();
+    }
     if (!outFile) {
-        std::cout << "Error: Could not save budget.\n";
-        return;
+        out << "Error: Could not write to " << LEDGER_PATH << ".\n";
+        return false;
     }
+    coverAppended(lines.size());
+    return true;
+}
 
-    outFile << month << "," << amount << "\n";
-    outFile.close();
+// Removes a row's contribution everywhere it is counted. Called while the store still has the old contents.
+void FinanceManager::forgetRow(uint32_t row) {
+    Transaction transaction = store.at(row);
+    spending.remove(transaction, row, store, dateIndex);
+    aggregates.remove(transaction);
+    timeline.remove(transaction);
+    dateIndex.remove(row, transaction.getDate());
+    categoryIndex.remove(row, transaction.getCategoryId());
+}
 
-    budgetMonth = month;
-    budgetAmount = amount;
+// Counts an edited row again under its new contents.
+void FinanceManager::rememberRow(uint32_t row) {
+    Transaction transaction = store.at(row);
+    aggregates.add(transaction);
+    timeline.add(transaction);
+    spending.add(transaction);
+    dateIndex.add(row, transaction.getDate());
+    categoryIndex.add(row, transaction.getCategoryId());
+}
+
+// Applies a #delete or #replace line that is already in the file.
+bool FinanceManager::applyRecord(const LedgerRow& row) {
+    if (!store.isLive(row.target)) return false;
+    uint32_t id = row.target;
+    forgetRow(id);
+    if (row.kind == LedgerRowKind::Delete) {
+        store.remove(id);
+        return true;
+    }
+    store.replace(id, Transaction(row.transactionType, row.amount, CategoryPool::intern(row.category), row.packedDate));
+    rememberRow(id);
+    return true;
+}
 
-    std::cout << "Budget of $" << amount << " set for " << month << ".\n";
+// Dropped lines are the #delete/#replace records plus the rows they deleted.
+// Not while the ledger has unreadable lines: the rewrite would lose them.
+// A compaction that finished meanwhile is adopted first, so the new one starts
+// from the offsets of the file as it is now.
+void FinanceManager::maybeCompact(std::ostream& out) {
+    absorbCompaction(out);
+    size_t dropped = store.removedRows() + store.editRecords();
+    if (compactor.running() || !coveredChecksum || !store.loadErrors().empty() ||
+        static_cast<double>(dropped) <= compactionFraction * static_cast<double>(store.liveRows() + dropped)) return;
+    compactor.start(LEDGER_PATH, store, coveredBytes);
 }
 
-// Loads budget for a specific month
-double FinanceManager::getMonthlyBudget(const std::string& month) {
-    std::ifstream inFile("data/budget.txt");
-    if (!inFile) return 0.0;
+// The compacted file holds the copied rows in newCovered bytes instead of
+// oldCovered, followed by everything that was appended meanwhile unchanged.
+void FinanceManager::absorbCompaction(std::ostream& out) {
+    std::optional<CompactionResult> result = compactor.takeResult();
+    if (!result) return;
+    if (!result->ok) {
+        out << "Warning: Could not compact " << LEDGER_PATH << " (" << result->error << ").\n";
+        return;
+    }
 
-    std::string line, fileMonth;
-    double amount;
+    coveredBytes = coveredBytes - result->oldCovered + result->newCovered;
+    coveredLines = SIZE_MAX;
+    snapshotCurrent = false;
+    store.compacted(result->removed, result->edits);
+    if (coveredChecksum) rememberLedgerPrefix(); // else a reload is due anyway
+    out << "Compacted " << LEDGER_PATH << " from " << result->bytesBefore << " to " << result->bytesAfter << " bytes.\n";
+}
+
+// Streams the given store rows through writer, then notes which part was shown.
+void FinanceManager::printRows(ResultWriter& writer, const std::vector<uint32_t>& rows,
+                               const std::vector<Field>& columns) const {
+    Profiler::count(Profiler::Counter::RowsMatched, rows.size());
+    for (uint32_t row : rows) {
+        if (!writer.row(store, row, columns)) break;
+    }
+    writer.finish(rows.size());
+}
 
-    while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        std::getline(ss, fileMonth, ',');
-        ss >> amount;
+// Saves a transaction to "data/transactions.txt" (or the binary ledger)
+void FinanceManager::saveTransactionToFile(const Transaction& transaction, std::ostream& out) {
+    ScopedTimer timer("saveTransactionToFile");
+    waitFor(LoadStage::Ready);
+    if (format == LedgerFormat::Segmented) {
+        std::string error;
+        if (!segments.append({transaction}, error)) {
+            out << "Error: Could not save transaction (" << error << ").\n";
+            return;
+        }
+        if (historyLoaded) {
+            recordTransaction(transaction);
+        } else if (loadedMonths.count(packedMonth(transaction.getDate()))) {
+            aggregates.add(transaction);
+            spending.add(transaction);
+        }
+        out << "Transaction saved to file.\n";
+        return;
+    }
 
-        if (fileMonth == month) {
-            inFile.close();
-            return amount;
+    if (format == LedgerFormat::Binary) {
+        std::string error;
+        if (!BinaryLedger::append(BINARY_LEDGER_PATH, transaction, error)) {
+            out << "Error: Could not save transaction (" << error << ").\n";
+            return;
         }
+        recordTransaction(transaction);
+        out << "Transaction saved to file.\n";
+        return;
     }
 
-    inFile.close();
-    return 0.0;
+    std::string line;
+    BufferedLedgerWriter::formatLine(transaction, line);
+    if (!appendToLedger(line, out)) return;
+    recordTransaction(transaction);
+    out << "Transaction saved to file.\n";
 }
 
-// Calculates total expenses for a specific month (e.g., "2025-04")
-double FinanceManager::getMonthlyExpenseTotal(const std::string& month) {
-    std::ifstream inFile("data/transactions.txt");
-    if (!inFile) return 0.0;
+// Edits need the text ledger (the other backends have no record lines) and a live id.
+bool FinanceManager::checkEditable(size_t id, std::ostream& out) {
+    if (format != LedgerFormat::Text) {
+        out << "Error: Transactions can only be edited or deleted in the text ledger.\n";
+        return false;
+    }
+    if (!store.isLive(id)) {
+        out << "Error: No transaction with id " << id << ".\n";
+        return false;
+    }
+    return true;
+}
 
-    std::string line;
-    double totalExpense = 0.0;
-
-    while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        std::string date, type, category, amountStr;
-
-        std::getline(ss, date, ',');
-        std::getline(ss, type, ',');
-        std::getline(ss, category, ',');
-        std::getline(ss, amountStr, ',');
-
-        // Only try to process valid expense lines
-        if (type == "expense" && date.substr(0, 7) == month) {
-            try {
-                if (!amountStr.empty()) {
-                    double amount = std::stod(amountStr);
-                    totalExpense += amount;
-                }
-            } catch (const std::invalid_argument& e) {
-                std::cout << "Skipping invalid transaction (bad amount): " << amountStr << "\n";
-            }
-        }
+// Lists the rows of one day with their ids, for choosing one to edit or delete.
+void FinanceManager::showTransactionsWithIds(const std::string& date, std::ostream& out) {
+    ScopedTimer timer("showTransactionsWithIds");
+    waitFor(LoadStage::Ready);
+    if (!store.isLoaded()) {
+        out << "Error: Could not open transactions file.\n";
+        return;
+    }
+
+    std::vector<uint32_t> rows;
+    int32_t packed = 0;
+    if (packDate(date, packed)) {
+        DateIndex::Range day = dateIndex.on(packed);
+        rows.assign(day.begin, day.end);
     }
 
-    inFile.close();
-    return totalExpense;
+    ResultWriter writer(out, output);
+    writer.note("\nTransactions on " + date + ":\n");
+    printRows(writer, rows, {Field::Id, Field::Date, Field::Type, Field::Category, Field::Amount});
+    if (rows.empty()) writer.note("No transactions found for this date.\n");
 }
 
-// Filters transactions by category.
-void FinanceManager::filterTransactionsByCategory(const std::string& selectedCategory) {
-    std::ifstream inFile("data/transactions.txt");
-    if (!inFile) {
-        std::cout << "Error: Could not open transactions file.\n";
+// Appends "#delete,<id>" and takes the row out of memory.
+bool FinanceManager::deleteTransaction(size_t id, std::ostream& out) {
+    ScopedTimer timer("deleteTransaction");
+    waitFor(LoadStage::Ready);
+    if (!checkEditable(id, out)) return false;
+
+    if (!appendToLedger("#delete," + std::to_string(id) + "\n", out)) return false;
+    if (!store.isLive(id)) {
+        out << "Error: Transaction #" << id << " was just deleted by another program.\n";
+        return false;
+    }
+    forgetRow(static_cast<uint32_t>(id));
+    store.remove(id);
+    out << "Transaction #" << id << " deleted.\n";
+    maybeCompact(out);
+    return true;
+}
+
+// Appends "#replace,<id>,<line>"; the row keeps its id and its place in file order.
+bool FinanceManager::replaceTransaction(size_t id, const Transaction& transaction, std::ostream& out) {
+    ScopedTimer timer("replaceTransaction");
+    waitFor(LoadStage::Ready);
+    if (!checkEditable(id, out)) return false;
+
+    std::string line = "#replace," + std::to_string(id) + ",";
+    BufferedLedgerWriter::formatLine(transaction, line);
+    if (!appendToLedger(line, out)) return false;
+    if (!store.isLive(id)) {
+        out << "Error: Transaction #" << id << " was just deleted by another program.\n";
+        return false;
+    }
+    forgetRow(static_cast<uint32_t>(id));
+    store.replace(id, transaction);
+    rememberRow(static_cast<uint32_t>(id));
+    out << "Transaction #" << id << " updated.\n";
+    maybeCompact(out);
+    return true;
+}
+
+// Loads and displays all transactions from the file
+void FinanceManager::loadTransactionsFromFile(std::ostream& out) {
+    ScopedTimer timer("loadTransactionsFromFile");
+    loadHistory();
+    if (!store.isLoaded()) {
+        out << "Error: Could not open transactions file.\n";
         return;
     }
 
-    std::string line;
-    bool found = false;
+    ResultWriter writer(out, output);
+    writer.note("\nSaved Transactions:\n");
+
+    Profiler::count(Profiler::Counter::RowsMatched, store.liveRows());
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (store.isLive(i) && !writer.row(store, static_cast<uint32_t>(i))) break;
+    }
+    writer.finish(store.liveRows());
 
-    std::cout << "\nTransactions in category: " << selectedCategory << "\n";
+    Money income, expenses;
+    store.totals(income, expenses);
+    writer.note(std::to_string(store.liveRows()) + " transactions. Income: $" + income.toString() +
+                "  Expenses: $" + expenses.toString() + "\n");
+}
 
-    while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        std::string date, type, category, amountStr;
+// Sets a monthly budget for a specific month (e.g., "2025-04"). A later budget for the same month replaces it.
+void FinanceManager::setMonthlyBudget(const std::string& month, Money amount, std::ostream& out) {
+    ScopedTimer timer("setMonthlyBudget");
+    waitFor(LoadStage::Budgets);
+    if (!budgets.set(month, amount)) {
+        out << "Error: Could not save budget.\n";
+        return;
+    }
 
-        std::getline(ss, date, ',');
-        std::getline(ss, type, ',');
-        std::getline(ss, category, ',');
-        std::getline(ss, amountStr, ',');
+    out << "Budget of $" << amount << " set for " << month << ".\n";
+}
 
-        if (category == selectedCategory) {
-            double amount = std::stod(amountStr);
-            Transaction t(type, amount, category, date);
-            t.display();
-            found = true;
-        }
+// Looks up the budget for a specific month
+Money FinanceManager::getMonthlyBudget(const std::string& month) {
+    ScopedTimer timer("getMonthlyBudget");
+    waitFor(LoadStage::Budgets);
+    return budgets.get(month);
+}
+
+// Calculates total expenses for a specific month (e.g., "2025-04")
+Money FinanceManager::getMonthlyExpenseTotal(const std::string& month) {
+    ScopedTimer timer("getMonthlyExpenseTotal");
+    loadMonth(month);
+    return aggregates.monthTotals(month).expense;
+}
+
+// Filters transactions by category.
+void FinanceManager::filterTransactionsByCategory(const std::string& selectedCategory, std::ostream& out) {
+    filterTransactionsByCategories({selectedCategory}, out);
+}
+
+// Filters transactions in any of the given categories.
+void FinanceManager::filterTransactionsByCategories(const std::vector<std::string>& selectedCategories,
+                                                    std::ostream& out) {
+    ScopedTimer timer("filterTransactionsByCategories");
+    loadHistory();
+    if (!store.isLoaded()) {
+        out << "Error: Could not open transactions file.\n";
+        return;
+    }
+
+    std::vector<uint16_t> ids;
+    for (const std::string& name : selectedCategories) {
+        uint16_t id = 0;
+        if (CategoryPool::find(name, id)) ids.push_back(id);
     }
 
-    if (!found) {
-        std::cout << "No transactions found in this category.\n";
+    Query query;
+    query.where = Predicate::categories(ids);
+    QueryResult result = engine.run(query);
+
+    std::string heading = selectedCategories.size() > 1 ? "\nTransactions in categories: " : "\nTransactions in category: ";
+    for (size_t i = 0; i < selectedCategories.size(); ++i) {
+        heading += (i > 0 ? " or " : "") + selectedCategories[i];
     }
 
-    inFile.close();
+    ResultWriter writer(out, output);
+    writer.note(heading + "\n");
+    printRows(writer, result.rows);
+
+    if (result.rows.empty()) {
+        writer.note("No transactions found in this category.\n");
+    }
 }
 
 // Filters transactions by a specific date.
-void FinanceManager::filterTransactionsByDate(const std::string& date) {
-    std::ifstream inFile("data/transactions.txt");
-    if (!inFile) {
-        std::cout << "Error: Could not open transactions file.\n";
+void FinanceManager::filterTransactionsByDate(const std::string& date, std::ostream& out) {
+    ScopedTimer timer("filterTransactionsByDate");
+    loadHistory();
+    if (!store.isLoaded()) {
+        out << "Error: Could not open transactions file.\n";
         return;
     }
 
-    std::string line;
-    bool found = false;
-
-    std::cout << "\nTransactions on: " << date << "\n";
+    std::vector<uint32_t> rows;
+    int32_t packed = 0;
+    if (packDate(date, packed)) {
+        Query query;
+        query.where = Predicate::dateRange(packed, packed);
+        rows = engine.run(query).rows;
+    }
 
-    while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        std::string tDate, type, category, amountStr;
+    ResultWriter writer(out, output);
+    writer.note("\nTransactions on: " + date + "\n");
+    printRows(writer, rows);
 
-        std::getline(ss, tDate, ',');
-        std::getline(ss, type, ',');
-        std::getline(ss, category, ',');
-        std::getline(ss, amountStr, ',');
+    if (rows.empty()) {
+        writer.note("No transactions found for this date.\n");
+    }
+}
 
-        if (tDate == date) {
-            double amount = std::stod(amountStr);
-            Transaction t(type, amount, category, tDate);
-            t.display();
-            found = true;
-        }
+// Filters transactions that fall between two dates, inclusive, in date order.
+void FinanceManager::filterTransactionsByDateRange(const std::string& from, const std::string& to, std::ostream& out) {
+    ScopedTimer timer("filterTransactionsByDateRange");
+    loadHistory();
+    if (!store.isLoaded()) {
+        out << "Error: Could not open transactions file.\n";
+        return;
     }
 
-    if (!found) {
-        std::cout << "No transactions found for this date.\n";
+    std::vector<uint32_t> rows;
+    int32_t first = 0, last = 0;
+    if (packDate(from, first) && packDate(to, last)) {
+        Query query;
+        query.where = Predicate::dateRange(first, last);
+        query.order = SortOrder::Date;
+        rows = engine.run(query).rows;
     }
 
-    inFile.close();
+    ResultWriter writer(out, output);
+    writer.note("\nTransactions from " + from + " to " + to + ":\n");
+    printRows(writer, rows);
+
+    if (rows.empty()) {
+        writer.note("No transactions found in this date range.\n");
+    }
 }
 
-// Filters transactions by less than or greater than the amount input.
-void FinanceManager::filterTransactionsByAmount(double amount, bool greaterThan) {
-    std::ifstream inFile("data/transactions.txt");
-    if (!inFile) {
-        std::cout << "Error: Could not open transactions file.\n";
+// Filters transactions by less than or greater than the amount input, optionally of one type only.
+void FinanceManager::filterTransactionsByAmount(Money amount, bool greaterThan, std::optional<TransactionType> type,
+                                                std::ostream& out) {
+    ScopedTimer timer("filterTransactionsByAmount");
+    loadHistory();
+    if (!store.isLoaded()) {
+        out << "Error: Could not open transactions file.\n";
         return;
     }
 
-    std::string line;
-    bool found = false;
+    Query query;
+    Predicate amountTest = greaterThan ? Predicate::amountAtLeast(amount) : Predicate::amountAtMost(amount);
+    query.where = type ? Predicate::allOf({amountTest, Predicate::type(*type)}) : amountTest;
+    QueryResult result = engine.run(query);
+
+    ResultWriter writer(out, output);
+    writer.note(std::string("\n") + (type ? (*type == TransactionType::Income ? "Income t" : "Expense t") : "T") +
+                "ransactions with amount " +
+                (greaterThan ? "greater than or equal to " : "less than or equal to ") + "$" + amount.toString() + ":\n");
+    printRows(writer, result.rows);
+
+    if (result.rows.empty()) {
+        writer.note("No transactions matched the amount filter.\n");
+    }
+}
+
+// Runs a combined query and prints the requested columns with totals over all matches.
+void FinanceManager::searchTransactions(const Query& query, std::ostream& out) {
+    ScopedTimer timer("searchTransactions");
+    loadHistory();
+    if (!store.isLoaded()) {
+        out << "Error: Could not open transactions file.\n";
+        return;
+    }
 
-    std::cout << "\nTransactions with amount ";
-    std::cout << (greaterThan ? "greater than or equal to " : "less than or equal to ") << "$" << amount << ":\n";
+    QueryResult result = engine.run(query);
 
-    while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        std::string date, type, category, amountStr;
+    ResultWriter writer(out, output);
+    writer.note("\nSearch results:\n");
+    printRows(writer, result.rows, query.columns);
 
-        std::getline(ss, date, ',');
-        std::getline(ss, type, ',');
-        std::getline(ss, category, ',');
-        std::getline(ss, amountStr, ',');
+    if (result.rows.empty()) {
+        writer.note("No transactions matched the search.\n");
+    } else {
+        writer.note("Matched income: $" + result.income.toString() +
+                    "  Matched expenses: $" + result.expense.toString() + "\n");
+    }
+}
 
-        if (!amountStr.empty()) {
-            double amt = std::stod(amountStr);
-            bool matches = greaterThan ? amt >= amount : amt <= amount;
+// Bulk import. Rows are checked with the same rules as the Add Transaction prompt,
+// collected into batches and appended with one write and one fsync per batch.
+bool FinanceManager::importTransactions(const std::string& path, size_t batchSize) {
+    ScopedTimer timer("importTransactions");
+    loadHistory();
+    auto start = std::chrono::steady_clock::now();
+    if (batchSize == 0) batchSize = 1;
+
+    // Held for the whole import, so a compaction finishing meanwhile copies the new rows across.
+    std::unique_lock<std::mutex> fileLock(compactor.fileMutex(), std::defer_lock);
+    if (format == LedgerFormat::Text) {
+        fileLock.lock();
+        if (!catchUpBeforeAppend(std::cout)) return false;
+    }
+    BufferedLedgerWriter writer;
+    if (format == LedgerFormat::Text && !writer.open(LEDGER_PATH)) {
+        std::cout << "Error: Could not open " << LEDGER_PATH << " for appending.\n";
+        return false;
+    }
 
-            if (matches) {
-                Transaction t(type, amt, category, date);
-                t.display();
-                found = true;
+    std::vector<Transaction> batch;
+    batch.reserve(batchSize);
+    std::vector<ParseError> rejected;
+    size_t imported = 0, batches = 0, appendedBytes = 0;
+    bool writeFailed = false;
+
+    auto flush = [&]() {
+        if (batch.empty() || writeFailed) return;
+        if (format == LedgerFormat::Binary) {
+            std::string error;
+            if (!BinaryLedger::appendBatch(BINARY_LEDGER_PATH, batch, error)) {
+                std::cout << "Error: Could not save transactions (" << error << ").\n";
+                writeFailed = true;
+                return;
+            }
+            appendedBytes += batch.size() * sizeof(BinaryRecord);
+        } else if (format == LedgerFormat::Segmented) {
+            uint64_t before = segments.totalBytes();
+            std::string error;
+            if (!segments.append(batch, error)) {
+                std::cout << "Error: Could not save transactions (" << error << ").\n";
+                writeFailed = true;
+                return;
+            }
+            appendedBytes += segments.totalBytes() - before;
+        } else {
+            for (const Transaction& transaction : batch) writer.append(transaction);
+            if (!writer.commit()) {
+                std::cout << "Error: Could not write to " << LEDGER_PATH << ".\n";
+                writeFailed = true;
+                return;
             }
         }
-    }
+        recordBatch(batch);
+        imported += batch.size();
+        ++batches;
+        batch.clear();
+    };
 
-    if (!found) {
-        std::cout << "No transactions matched the amount filter.\n";
+    LedgerParser parser;
+    bool opened = parser.parseFile(path, [&](const LedgerRow& row) {
+        if (row.kind == LedgerRowKind::Unreadable) return; // already in rejected
+        std::string type(row.type), category(row.category);
+        if (row.kind != LedgerRowKind::Transaction) {
+            rejected.push_back({row.lineNumber, "edit records cannot be imported", std::string(row.text)});
+        } else if (!isValidDate(std::string(row.date))) {
+            rejected.push_back({row.lineNumber, "invalid date", std::string(row.date)});
+        } else if (!isValidCategory(type, category)) {
+            rejected.push_back({row.lineNumber, "unknown " + type + " category", category});
+        } else if (row.amount < Money()) {
+            rejected.push_back({row.lineNumber, "negative amount", row.amount.toString()});
+        } else {
+            batch.emplace_back(row.transactionType, row.amount, CategoryPool::intern(row.category), row.packedDate);
+            if (batch.size() >= batchSize) flush();
+        }
+    }, rejected);
+    flush();
+    writer.close();
+    if (format == LedgerFormat::Text && writer.bytesWritten() > 0) coverAppended(writer.bytesWritten());
+    Profiler::count(Profiler::Counter::RowsParsed, imported + batch.size() + rejected.size());
+    Profiler::count(Profiler::Counter::ParseErrors, rejected.size());
+    Profiler::count(Profiler::Counter::BytesWritten,
+                    format == LedgerFormat::Text ? writer.bytesWritten() : appendedBytes);
+
+    if (!opened) {
+        std::cout << "Error: Could not open " << path << ".\n";
+        return false;
     }
 
-    inFile.close();
+    std::sort(rejected.begin(), rejected.end(),
+              [](const ParseError& a, const ParseError& b) { return a.lineNumber < b.lineNumber; });
+    const size_t shown = 20;
+    for (size_t i = 0; i < rejected.size() && i < shown; ++i) {
+        std::cout << "Line " << rejected[i].lineNumber << ": " << rejected[i].message
+                  << " (" << rejected[i].text << ")\n";
+    }
+    if (rejected.size() > shown) std::cout << "... and " << rejected.size() - shown << " more rejected lines.\n";
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t bytes = format == LedgerFormat::Text ? writer.bytesWritten() : appendedBytes;
+    double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+
+    std::cout << "Imported " << imported << " transactions, rejected " << rejected.size() << ".\n";
+    std::cout << "Batches (fsyncs): " << batches << ", bytes written: " << bytes << "\n";
+    std::cout << "Elapsed: " << seconds << " s";
+    if (seconds > 0) {
+        std::cout << ", " << static_cast<size_t>(imported / seconds) << " rows/s, "
+                  << megabytes / seconds << " MB/s";
+    }
+    std::cout << "\n";
+    return !writeFailed;
 }
 
 // Generates a summary of the transactions for chosen month.
-void FinanceManager::generateMonthlyReport(const std::string& month) {
-    std::ifstream inFile("data/transactions.txt");
-    if (!inFile) {
-        std::cout << "Error: Could not open transactions file.\n";
+void FinanceManager::generateMonthlyReport(const std::string& month, std::ostream& out) {
+    ScopedTimer timer("generateMonthlyReport");
+    loadMonth(month);
+    if (!ledgerAvailable()) {
+        out << "Error: Could not open transactions file.\n";
         return;
     }
 
-    std::string line;
-    double totalIncome = 0.0;
-    double totalExpenses = 0.0;
+    Totals monthTotals = aggregates.monthTotals(month);
+    Money totalIncome = monthTotals.income;
+    Money totalExpenses = monthTotals.expense;
 
-    while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        std::string date, type, category, amountStr;
+    out << "\nSummary for " << month << "\n";
+    out << "-----------------------------\n";
+    out << "Total Income:   $" << totalIncome << "\n";
+    out << "Total Expenses: $" << totalExpenses << "\n";
+    out << "Balance:        $" << (totalIncome - totalExpenses) << "\n";
+}
 
-        std::getline(ss, date, ',');
-        std::getline(ss, type, ',');
-        std::getline(ss, category, ',');
-        std::getline(ss, amountStr, ',');
+// Month after a packed month, rolling December over into the next year.
+static int32_t nextMonth(int32_t month) {
+    return month % 16 == 12 ? (month / 16 + 1) * 16 + 1 : month + 1;
+}
 
-        if (date.substr(0, 7) == month && !amountStr.empty()) {
-            double amount = std::stod(amountStr);
+// Number of calendar months in from..to inclusive.
+static int64_t monthsBetween(int32_t from, int32_t to) {
+    return (to / 16 - from / 16) * 12 + (to % 16 - from % 16) + 1;
+}
 
-            if (type == "income") {
-                totalIncome += amount;
-            } else if (type == "expense") {
-                totalExpenses += amount;
-            }
-        }
+// Prints one row of the range report table.
+static void printRangeRow(std::ostream& out, const std::string& label, const Totals& totals, int64_t months) {
+    out << std::left << std::setw(10) << label << std::right
+              << std::setw(14) << ("$" + totals.income.toString())
+              << std::setw(14) << ("$" + totals.expense.toString())
+              << std::setw(14) << ("$" + (totals.income - totals.expense).toString())
+              << std::setw(16) << ("$" + Money::fromCents(totals.expense.cents() / months).toString()) << "\n";
+}
+
+// Summarises a range of months, one row per month, quarter or year, from the
+// running totals: each row costs the same however many transactions it covers.
+void FinanceManager::generateRangeReport(const std::string& fromMonth, const std::string& toMonth, ReportPeriod period,
+                                         std::ostream& out) {
+    ScopedTimer timer("generateRangeReport");
+    loadHistory();
+    if (!store.isLoaded()) {
+        out << "Error: Could not open transactions file.\n";
+        return;
     }
 
-    inFile.close();
+    int32_t first = 0, last = 0;
+    if (!packMonth(fromMonth, first) || !packMonth(toMonth, last)) return;
+    if (last < first) std::swap(first, last);
+
+    const char* names[] = {"month", "quarter", "year"};
+    out << "\nSummary for " << unpackMonth(first) << " to " << unpackMonth(last)
+              << " by " << names[static_cast<int>(period)] << "\n";
+    out << std::left << std::setw(10) << "Period" << std::right << std::setw(14) << "Income"
+              << std::setw(14) << "Expenses" << std::setw(14) << "Balance" << std::setw(16) << "Avg exp/month" << "\n";
+    out << std::string(68, '-') << "\n";
+
+    for (int32_t start = first; start <= last;) {
+        int year = start / 16, month = start % 16;
+        int32_t end = start;
+        std::string label = unpackMonth(start);
+        if (period == ReportPeriod::Quarter) {
+            end = year * 16 + ((month - 1) / 3 + 1) * 3;
+            label = std::to_string(year) + "-Q" + std::to_string((month - 1) / 3 + 1);
+        } else if (period == ReportPeriod::Year) {
+            end = year * 16 + 12;
+            label = std::to_string(year);
+        }
+        if (end > last) end = last;
+
+        printRangeRow(out, label, timeline.range(start, end), monthsBetween(start, end));
+        start = nextMonth(end);
+    }
 
-    std::cout << "\nSummary for " << month << "\n";
-    std::cout << "-----------------------------\n";
-    std::cout << "Total Income:   $" << totalIncome << "\n";
-    std::cout << "Total Expenses: $" << totalExpenses << "\n";
-    std::cout << "Balance:        $" << (totalIncome - totalExpenses) << "\n";
+    int64_t months = monthsBetween(first, last);
+    Totals total = timeline.range(first, last);
+    out << std::string(68, '-') << "\n";
+    printRangeRow(out, "Total", total, months);
+    out << "Average per month over " << months << " months: income $"
+              << Money::fromCents(total.income.cents() / months) << ", expenses $"
+              << Money::fromCents(total.expense.cents() / months) << "\n";
+
+    // Expense categories over the whole range, largest first.
+    std::vector<std::pair<Money, uint16_t>> categories;
+    for (size_t c = 0; c < timeline.categoryCount(); ++c) {
+        Money spent = timeline.categoryRange(static_cast<uint16_t>(c), first, last).expense;
+        if (spent > Money()) categories.push_back({spent, static_cast<uint16_t>(c)});
+    }
+    std::stable_sort(categories.begin(), categories.end(),
+                     [](const auto& a, const auto& b) { return b.first < a.first; });
+
+    if (!categories.empty()) out << "\nExpenses by category:\n";
+    for (const auto& entry : categories) {
+        std::string name(CategoryPool::name(entry.second));
+        int share = total.expense.cents() > 0
+            ? static_cast<int>(entry.first.cents() * 100 / total.expense.cents()) : 0;
+        out << std::left << std::setw(15) << name << std::right << std::setw(14)
+                  << ("$" + entry.first.toString()) << std::setw(5) << share << "%\n";
+    }
 }
 
 // Generates a ASCII bar chart for a chosen month.
-void FinanceManager::showExpenseBarChart(const std::string& month) {
-    std::ifstream inFile("data/transactions.txt");
-    if (!inFile) {
-        std::cout << "Error: Could not open transactions file.\n";
+void FinanceManager::showExpenseBarChart(const std::string& month, std::ostream& out) {
+    ScopedTimer timer("showExpenseBarChart");
+    loadMonth(month);
+    if (!ledgerAvailable()) {
+        out << "Error: Could not open transactions file.\n";
         return;
     }
 
-    // Predefined categories for consistency
-    std::vector <std::string> categories = {
-        "Bills", "Charity", "Eating Out", "Entertainment", "Expenses", "Family",
-        "Finances", "General", "Gifts", "Groceries", "Holidays", "Personal Care",
-        "Savings", "Shopping", "Transfers", "Transport"
-    };
+    // Totals are indexed by category id, so the expense categories are read straight off in registry order.
+    const std::vector<Totals>& totals = aggregates.categoryTotals(month);
+
+    out << "\nExpense Breakdown for " << month << "\n";
+    out << "------------------------------------------\n";
+
+    Money otherTotal;
+    std::string otherNames;
+    for (size_t id = 0; id < totals.size(); ++id) {
+        Money spent = totals[id].expense;
+        if (!(spent > Money())) continue;
+        std::string_view name = CategoryPool::name(static_cast<uint16_t>(id));
+        if (!CategoryRegistry::allows(static_cast<uint16_t>(id), TransactionType::Expense)) {
+            // Income or unknown categories with expenses: counted below rather than dropped.
+            otherTotal += spent;
+            otherNames += (otherNames.empty() ? "" : ", ") + std::string(name);
+            continue;
+        }
+        int barLength = static_cast<int>(spent.cents() / 1000); // one bar per $10
+        out << name;
+        if (name.length() < 15) out << std::string(15 - name.length(), ' ');
+        out << " | " << std::string(barLength, '|') << " $" << spent << "\n";
+    }
+    if (otherTotal > Money()) {
+        out << "Not in the expense list: " << otherNames << " ($" << otherTotal << ")\n";
+    }
+}
 
-    std::map<std::string, double> totals;
-    for (const std::string& cat : categories) {
-        totals[cat] = 0.0;
+// Lists the largest expenses, of one month and/or one category when given.
+// Answered from the per-cell heaps, so it never scans the ledger.
+void FinanceManager::showLargestExpenses(size_t count, const std::string& month, const std::string& category,
+                                         std::ostream& out) {
+    ScopedTimer timer("showLargestExpenses");
+    std::optional<int32_t> monthKey;
+    int32_t key = 0;
+    if (!month.empty() && packMonth(month, key)) monthKey = key;
+    if (monthKey) loadMonth(month);
+    else loadHistory();
+    if (!ledgerAvailable()) {
+        out << "Error: Could not open transactions file.\n";
+        return;
     }
 
-    std::string line;
-    while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        std::string date, type, category, amountStr;
-
-        std::getline(ss, date, ',');
-        std::getline(ss, type, ',');
-        std::getline(ss, category, ',');
-        std::getline(ss, amountStr, ',');
-
-        if (date.substr(0, 7) == month && type == "expense" && !amountStr.empty()) {
-            double amount = std::stod(amountStr);
-            if (totals.find(category) != totals.end()) {
-                totals[category] += amount;
-            }
-        }
+    std::vector<LargeAmount> largest;
+    uint16_t id = 0;
+    if (category.empty() || CategoryPool::find(category, id)) {
+        largest = spending.largest(count, monthKey,
+                                   category.empty() ? std::nullopt : std::optional<uint16_t>(id));
+    }
+
+    ResultWriter writer(out, output);
+    writer.note("\nLargest expenses" + (category.empty() ? std::string() : " in " + category) +
+                (month.empty() ? std::string() : " for " + month) + ":\n");
+    Profiler::count(Profiler::Counter::RowsMatched, largest.size());
+    for (const LargeAmount& entry : largest) {
+        if (!writer.row(Transaction(TransactionType::Expense, Money::fromCents(entry.cents), entry.category, entry.date))) break;
+    }
+    writer.finish(largest.size());
+
+    if (largest.empty()) {
+        writer.note("No expenses found.\n");
+    }
+}
+
+// Typical expense sizes per category: median, 90th and 99th percentile from
+// the mergeable sketches (within 1%), and the exact largest amount.
+void FinanceManager::showSpendingDistribution(const std::string& month, std::ostream& out) {
+    ScopedTimer timer("showSpendingDistribution");
+    std::optional<int32_t> monthKey;
+    int32_t key = 0;
+    if (!month.empty() && packMonth(month, key)) monthKey = key;
+    if (monthKey) loadMonth(month);
+    else loadHistory();
+    if (!ledgerAvailable()) {
+        out << "Error: Could not open transactions file.\n";
+        return;
+    }
+
+    std::map<std::string, QuantileSketch> categories;
+    for (const auto& entry : spending.byCategory(monthKey)) {
+        categories.emplace(std::string(CategoryPool::name(entry.first)), entry.second);
+    }
+
+    out << "\nExpense sizes " << (month.empty() ? std::string("over the whole ledger") : "for " + month) << "\n";
+    if (categories.empty()) {
+        out << "No expenses found.\n";
+        return;
     }
+    out << std::left << std::setw(15) << "Category" << std::right << std::setw(9) << "Count"
+        << std::setw(13) << "Median" << std::setw(13) << "p90" << std::setw(13) << "p99"
+        << std::setw(13) << "Largest" << "\n";
+    out << std::string(76, '-') << "\n";
+    for (const auto& entry : categories) {
+        const QuantileSketch& sketch = entry.second;
+        out << std::left << std::setw(15) << entry.first << std::right << std::setw(9) << sketch.count()
+            << std::setw(13) << ("$" + Money::fromCents(sketch.quantile(0.5)).toString())
+            << std::setw(13) << ("$" + Money::fromCents(sketch.quantile(0.9)).toString())
+            << std::setw(13) << ("$" + Money::fromCents(sketch.quantile(0.99)).toString())
+            << std::setw(13) << ("$" + Money::fromCents(sketch.max()).toString()) << "\n";
+    }
+    out << "Median and percentiles are within 1% of the exact value.\n";
+}
 
-    inFile.close();
+// One month of the budget report.
+struct BudgetLine {
+    int32_t month;   // packedMonth()
+    bool budgeted;   // false: the month only has transactions
+    Money budget;
+    Money actual;    // expenses
+};
+
+// Merge-joins the month-ordered budgets with the month-ordered ledger totals,
+// keeping every month that appears on either side.
+static std::vector<BudgetLine> joinBudgets(const std::vector<std::pair<int32_t, Money>>& budgets,
+                                           const std::vector<std::pair<int32_t, Totals>>& months) {
+    std::vector<BudgetLine> lines;
+    lines.reserve(std::max(budgets.size(), months.size()));
+    size_t b = 0, m = 0;
+    while (b < budgets.size() || m < months.size()) {
+        bool takeBudget = b < budgets.size() && (m == months.size() || budgets[b].first <= months[m].first);
+        bool takeMonth = m < months.size() && (b == budgets.size() || months[m].first <= budgets[b].first);
+        lines.push_back({takeBudget ? budgets[b].first : months[m].first, takeBudget,
+                         takeBudget ? budgets[b].second : Money(), takeMonth ? months[m].second.expense : Money()});
+        if (takeBudget) ++b;
+        if (takeMonth) ++m;
+    }
+    return lines;
+}
 
-    std::cout << "\nExpense Breakdown for " << month << "\n";
-    std::cout << "------------------------------------------\n";
+// One amount column of the budget report: "-12.50" in csv and jsonl, "-$12.50" in the table.
+static std::string reportAmount(Money amount, OutputFormat outputFormat) {
+    std::string text = amount.toString();
+    if (outputFormat != OutputFormat::Table) return text;
+    return text[0] == '-' ? "-$" + text.substr(1) : "$" + text;
+}
+
+// Share of the budget spent, e.g. "87.5"; empty when there is no budget to divide by.
+static std::string percentUsed(const BudgetLine& line) {
+    if (!line.budgeted || line.budget.cents() <= 0) return "";
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1)
+         << static_cast<double>(line.actual.cents()) * 100 / static_cast<double>(line.budget.cents());
+    return text.str();
+}
 
-    for (const auto& pair : totals) {
-        if (pair.second > 0) {
-            int barLength = static_cast<int>(pair.second / 10); 
-            std::cout << pair.first;
-            if (pair.first.length() < 15) std::cout << std::string(15 - pair.first.length(), ' ');
-            std::cout << " | " << std::string(barLength, '|') << " $" << pair.second << "\n";
+// Budget, actual spending, variance (budget - actual), percent used and the
+// overspend accumulated so far, for every month in either file. Built from the
+// month totals and the budget table in one merge pass; no transactions are read.
+std::string FinanceManager::budgetReport(OutputFormat outputFormat) {
+    std::vector<BudgetLine> lines = joinBudgets(budgets.sorted(), aggregates.sortedMonths());
+    Profiler::count(Profiler::Counter::RowsMatched, lines.size());
+
+    std::ostringstream text;
+    if (outputFormat == OutputFormat::Csv) {
+        text << "month,budget,actual,variance,percent_used,running_overspend\n";
+    } else if (outputFormat == OutputFormat::Table) {
+        text << "\nBudget vs actual, every month\n";
+        if (lines.empty()) {
+            text << "No budgets or transactions yet.\n";
+            return text.str();
+        }
+        text << std::left << std::setw(10) << "Month" << std::right << std::setw(14) << "Budget"
+             << std::setw(14) << "Actual" << std::setw(14) << "Variance" << std::setw(9) << "Used"
+             << std::setw(16) << "Overspend" << "\n";
+        text << std::string(77, '-') << "\n";
+    }
 
+    Money overspend, totalBudget, totalActual;
+    size_t monthsOver = 0;
+    for (const BudgetLine& line : lines) {
+        if (line.budgeted && line.actual > line.budget) {
+            overspend += line.actual - line.budget;
+            ++monthsOver;
+        }
+        if (line.budgeted) {
+            totalBudget += line.budget;
+            totalActual += line.actual;
+        }
+        std::string month = unpackMonth(line.month);
+        std::string percent = percentUsed(line);
+        const char* none = outputFormat == OutputFormat::Csv ? "" : outputFormat == OutputFormat::JsonLines ? "null" : "-";
+        std::string budget = line.budgeted ? reportAmount(line.budget, outputFormat) : none;
+        std::string actual = reportAmount(line.actual, outputFormat);
+        std::string variance = line.budgeted ? reportAmount(line.budget - line.actual, outputFormat) : none;
+        std::string running = reportAmount(overspend, outputFormat);
+
+        if (outputFormat == OutputFormat::Csv) {
+            text << month << ',' << budget << ',' << actual << ',' << variance << ',' << percent << ','
+                 << running << "\n";
+        } else if (outputFormat == OutputFormat::JsonLines) {
+            text << "{\"month\":\"" << month << "\",\"budget\":" << budget << ",\"actual\":" << actual
+                 << ",\"variance\":" << variance << ",\"percent_used\":" << (percent.empty() ? "null" : percent)
+                 << ",\"running_overspend\":" << running << "}\n";
+        } else {
+            text << std::left << std::setw(10) << month << std::right << std::setw(14) << budget
+                 << std::setw(14) << actual << std::setw(14) << variance
+                 << std::setw(9) << (percent.empty() ? "-" : percent + "%") << std::setw(16) << running << "\n";
         }
     }
+
+    if (outputFormat == OutputFormat::Table) {
+        text << "Budgeted months: " << reportAmount(totalActual, outputFormat) << " spent of "
+             << reportAmount(totalBudget, outputFormat) << ", " << monthsOver << " over budget, "
+             << reportAmount(overspend, outputFormat) << " overspent in total.\n";
+    }
+    return text.str();
+}
+
+// Prints the budget report in the listing format (table, csv or jsonl).
+// Without a ledger the budgeted months are still shown, with nothing spent.
+void FinanceManager::showBudgetReport(std::ostream& out) {
+    ScopedTimer timer("showBudgetReport");
+    loadHistory();
+    if (!ledgerAvailable() && budgets.size() == 0) {
+        out << "Error: Could not open transactions file.\n";
+        return;
+    }
+    out << budgetReport(output.format);
+}
+
+// Writes the budget report as CSV for other tools, replacing path in one step.
+bool FinanceManager::exportBudgetReport(const std::string& path, std::ostream& out) {
+    ScopedTimer timer("exportBudgetReport");
+    loadHistory();
+    if (!ledgerAvailable() && budgets.size() == 0) {
+        out << "Error: Could not open transactions file.\n";
+        return false;
+    }
+    std::string csv = budgetReport(OutputFormat::Csv);
+    if (!writeFileAtomically(path, csv)) {
+        out << "Error: Could not write " << path << ".\n";
+        return false;
+    }
+    Profiler::count(Profiler::Counter::BytesWritten, csv.size());
+    out << "Budget report saved to " << path << ".\n";
+    return true;
 }
@@ -1,25 +1,165 @@
 #ifndef FINANCEMANAGER_H
 #define FINANCEMANAGER_H
 #include "Transaction.h"
+#include "TransactionStore.h"
+#include "AggregateTable.h"
+#include "DateIndex.h"
+#include "FileWatcher.h"
+#include "LedgerCompactor.h"
+#include "LedgerParser.h"
+#include "MonthTimeline.h"
+#include "CategoryIndex.h"
+#include "QueryEngine.h"
+#include "ResultWriter.h"
+#include "SegmentedLedger.h"
+#include "SpendingStats.h"
+#include "BudgetStore.h"
+#include "Money.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <iostream>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
+
+// Which file the ledger lives in.
+enum class LedgerFormat {
+    Text,      // data/transactions.txt, CSV
+    Binary,    // data/transactions.bin, fixed-width records (see BinaryLedger.h)
+    Segmented  // data/ledger/YYYY-MM.csv, one file per month (see SegmentedLedger.h)
+};
+
+// How far the background load has got. Each stage includes the ones before it.
+enum class LoadStage {
+    Starting,
+    Budgets,  // budget.txt read
+    Totals,   // rows, month x category totals and spending stats ready
+    Ready     // date/category indexes and the month timeline built too
+};
+
+// How a range report groups its months.
+enum class ReportPeriod { Month, Quarter, Year };
 
 // Manages transactions, budgets, and reports
 class FinanceManager {
 public:
-    void saveTransactionToFile(const Transaction& transaction);             // append transaction
-    void loadTransactionsFromFile();                                        // read and display all
-    void setMonthlyBudget(const std::string& month, double amount);         // Set budget for specific month (e.g. "2025-04")
-    double getMonthlyBudget(const std::string& month);                      // Load budget for a specific month
-    double getMonthlyExpenseTotal(const std::string& month);                // Sum of expenses for the given month
-    void filterTransactionsByCategory(const std::string& selectedCategory); // list by category
-    void filterTransactionsByDate(const std::string& date);                 // list by date
-    void filterTransactionsByAmount(double amount, bool greaterThan);       // list by amount
-    void generateMonthlyReport(const std::string& month);                   // summary
-    void showExpenseBarChart(const std::string& month);                     // ASCII chart        
+    // Starts loading the ledger into memory on a background thread and returns at once;
+    // each method waits only for the part of the load it needs. loadThreads is the number of
+    // parse workers (0 = one per core). useSnapshot starts a text ledger from
+    // data/snapshot.bin when it still matches (see LedgerSnapshot.h).
+    explicit FinanceManager(LedgerFormat ledgerFormat = LedgerFormat::Text, unsigned loadThreads = 0,
+                            bool useSnapshot = false);
+    ~FinanceManager();
+    FinanceManager(const FinanceManager&) = delete;
+    FinanceManager& operator=(const FinanceManager&) = delete;
+
+    void waitUntilLoaded();                                                 // block until the whole ledger is in memory
+    void saveSnapshot();                                                    // persist parsed state for the next start
+    void refresh(std::ostream& out = std::cout);                            // apply changes other programs made to the files
+    void setAutoRefresh(bool on) { autoRefresh = on; }                      // refresh before every operation (default on)
+    void setCompactionFraction(double fraction) { compactionFraction = fraction; } // compact the text ledger once dropped
+                                                                            // lines pass this share of it (default 0.2, 1 = never)
+
+    // Every operation below prints to out, the console unless a daemon client asked.
+    void setOutputOptions(const OutputOptions& options) { output = options; } // format and paging of listings
+    void saveTransactionToFile(const Transaction& transaction, std::ostream& out = std::cout); // append transaction
+    void loadTransactionsFromFile(std::ostream& out = std::cout);           // display all
+    void setMonthlyBudget(const std::string& month, Money amount,
+                          std::ostream& out = std::cout);                   // Set budget for specific month (e.g. "2025-04")
+    Money getMonthlyBudget(const std::string& month);                       // Budget for a specific month (latest set wins)
+    Money getMonthlyExpenseTotal(const std::string& month);                 // Sum of expenses for the given month
+    void filterTransactionsByCategory(const std::string& selectedCategory,
+                                      std::ostream& out = std::cout);       // list by category
+    void filterTransactionsByCategories(const std::vector<std::string>& selectedCategories,
+                                        std::ostream& out = std::cout);     // list rows in any of them
+    void filterTransactionsByDate(const std::string& date, std::ostream& out = std::cout); // list by date
+    void filterTransactionsByDateRange(const std::string& from, const std::string& to,
+                                       std::ostream& out = std::cout);      // list from..to inclusive
+    void filterTransactionsByAmount(Money amount, bool greaterThan,
+                                    std::optional<TransactionType> type = std::nullopt,
+                                    std::ostream& out = std::cout);         // list by amount
+    void searchTransactions(const Query& query, std::ostream& out = std::cout); // any combination of filters
+    void generateMonthlyReport(const std::string& month, std::ostream& out = std::cout); // summary
+    void generateRangeReport(const std::string& fromMonth, const std::string& toMonth,
+                             ReportPeriod period, std::ostream& out = std::cout); // totals per month/quarter/year of a range
+    void showExpenseBarChart(const std::string& month, std::ostream& out = std::cout); // ASCII chart
+    void showLargestExpenses(size_t count, const std::string& month, const std::string& category,
+                             std::ostream& out = std::cout);                // top expenses; "" month/category = all
+    void showSpendingDistribution(const std::string& month, std::ostream& out = std::cout); // median/p90/p99 per category
+    void showBudgetReport(std::ostream& out = std::cout);                   // budget vs actual for every month, in the output format
+    bool exportBudgetReport(const std::string& path, std::ostream& out = std::cout); // same report as CSV in path
+
+    // Text ledger only. A transaction's id is its position in the ledger (see TransactionStore.h);
+    // deleting or editing one appends a #delete or #replace line, and a background
+    // compaction folds those lines back in once there are enough of them.
+    void showTransactionsWithIds(const std::string& date, std::ostream& out = std::cout); // a day's rows with their ids
+    bool deleteTransaction(size_t id, std::ostream& out = std::cout);
+    bool replaceTransaction(size_t id, const Transaction& transaction, std::ostream& out = std::cout); // same id, new contents
+
+    // Appends every valid row of a "date,type,category,amount" file to the ledger,
+    // batchSize rows per write + fsync, and prints a throughput summary. Returns false if nothing could be read or written.
+    bool importTransactions(const std::string& path, size_t batchSize = 10000);
 
 private:
-    std::string budgetMonth = ""; // last set month
-    double budgetAmount = 0.0;    // last set amount
+    void loadLedger(bool useSnapshot);                                      // the load itself, stage by stage
+    void finishStage(LoadStage stage, const std::string& notes);            // publish a stage to waiting queries
+    void waitFor(LoadStage stage);                                          // block with a progress line until stage is done
+    bool loadFromSnapshot(std::ostream& notes);                             // snapshot + tail, text ledger only
+    void applyExternalChanges(std::ostream& out);                           // pick up what other programs wrote
+    void readAppendedLines(size_t ledgerSize, std::ostream& out);           // text ledger: parse past coveredBytes
+    void reloadLedger(std::ostream& out);                                                  // text ledger: start over after a rewrite
+    std::string budgetReport(OutputFormat outputFormat);                    // text of the budget report
+    std::string unknownCategoryNote() const;                                // rows outside CategoryRegistry, for loadNotes
+    void rememberLedgerPrefix();                                            // checksum the covered bytes
+    bool ledgerPrefixMatches() const;                                       // the covered bytes are still what the store reflects
+    void loadHistory();                                                     // whole history: wait for the load, segmented loads every segment once
+    void loadMonth(const std::string& month);                               // one month's totals: wait for them, segmented folds in one file
+    bool ledgerAvailable() const;
+    void recordTransaction(const Transaction& transaction);                 // update store and indexes after a save
+    void recordBatch(const std::vector<Transaction>& batch);                // same for a whole import batch, once
+    bool catchUpBeforeAppend(std::ostream& out);                            // text ledger: read other programs' lines first; holds file lock
+    void coverAppended(size_t bytes);                                       // move coveredBytes past our own append
+    bool appendToLedger(const std::string& lines, std::ostream& out);       // text ledger: append and move coveredBytes past it
+    bool checkEditable(size_t id, std::ostream& out);                       // text ledger and a live id, else an error
+    void forgetRow(uint32_t row);                                           // take a live row out of totals and indexes
+    void rememberRow(uint32_t row);                                         // put an edited row back in
+    bool applyRecord(const LedgerRow& row);                                 // #delete/#replace read back; false if its id is not live
+    void maybeCompact(std::ostream& out);                                   // start a compaction if enough lines are dropped
+    void absorbCompaction(std::ostream& out);                               // adopt a finished compaction's byte offsets
+    void printRows(ResultWriter& writer, const std::vector<uint32_t>& rows,
+                   const std::vector<Field>& columns = {Field::Date, Field::Type, Field::Category, Field::Amount}) const;
+
+    LedgerFormat format;          // backend the ledger is read from and appended to
+    TransactionStore store;       // in-memory ledger
+    AggregateTable aggregates;    // month x category totals, kept in step with store
+    MonthTimeline timeline;       // running monthly totals for range reports
+    SpendingStats spending;       // largest expenses and amount sketches per month x category
+    DateIndex dateIndex;          // store rows ordered by date
+    CategoryIndex categoryIndex;  // store rows per category
+    QueryEngine engine{store, dateIndex, categoryIndex}; // evaluates every filter
+    BudgetStore budgets;          // month -> budget, last write wins
+    OutputOptions output;         // how listings are printed
+    SegmentedLedger segments;     // per-month files, used when format is Segmented
+    bool historyLoaded = true;    // false until a segmented ledger is fully in store
+    std::set<int32_t> loadedMonths; // segmented: months already folded into aggregates
+    unsigned threads;             // parse workers for a full load
+    size_t coveredBytes = 0;      // text ledger bytes the store reflects
+    size_t coveredLines = SIZE_MAX; // lines in those bytes, counted when first needed
+    std::optional<uint64_t> coveredChecksum; // of the covered bytes, to notice rewrites (none if unreadable)
+    FileWatcher watcher;          // ledger and budget files, for changes made by other programs
+    bool autoRefresh = true;      // apply those changes at the start of every operation
+    bool snapshotCurrent = false; // data/snapshot.bin already matches the store
+    LedgerCompactor compactor;    // background rewrite of the text ledger; its fileMutex guards appends
+    double compactionFraction = 0.2;
+
+    std::mutex loadMutex;                 // guards loadStage and loadNotes
+    std::condition_variable loadChanged;  // signalled when a stage finishes
+    LoadStage loadStage = LoadStage::Starting;
+    std::string loadNotes;                // messages from the load, printed by the next wait
+    std::thread loader;                   // runs loadLedger(); started last, after every member above exists
 };
 
 #endif
@@ -0,0 +1,164 @@
+#include "LedgerCompactor.h"
+#include "AtomicFile.h"
+#include "BufferedLedgerWriter.h"
+#include "LedgerParser.h"
+#include "LedgerSnapshot.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+LedgerCompactor::~LedgerCompactor() {
+    wait();
+}
+
+void LedgerCompactor::wait() {
+    if (worker.joinable()) worker.join();
+}
+
+bool LedgerCompactor::start(const std::string& path, const TransactionStore& store, size_t coveredBytes) {
+    if (busy) return false;
+    wait();
+    {
+        // Its offsets are the ones coveredBytes has to be adjusted by first.
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (finished) return false;
+    }
+
+    Rows rows{store.dates(), store.types(), store.categories(), store.cents(), store.live()};
+    CompactionResult result;
+    result.oldCovered = coveredBytes;
+    result.removed = store.removedRows();
+    result.edits = store.editRecords();
+
+    uint64_t covered = 0;
+    if (!checksumPrefix(path, coveredBytes, covered)) return false;
+    busy = true;
+    worker = std::thread([this, path, rows = std::move(rows), covered, result]() mutable {
+        run(std::move(path), std::move(rows), covered, std::move(result));
+    });
+    return true;
+}
+
+std::optional<CompactionResult> LedgerCompactor::takeResult() {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    std::optional<CompactionResult> result;
+    result.swap(finished);
+    return result;
+}
+
+bool LedgerCompactor::checksumPrefix(const std::string& path, size_t bytes, uint64_t& sum) {
+    if (bytes == 0) {
+        sum = LedgerSnapshot::checksum(nullptr, 0);
+        return true;
+    }
+    MappedFile ledger;
+    if (!ledger.open(path) || ledger.size() < bytes) return false;
+    sum = LedgerSnapshot::checksum(ledger.data(), bytes);
+    return true;
+}
+
+std::string LedgerCompactor::format(const Rows& rows) {
+    std::string text;
+    text.reserve(rows.dates.size() * 40);
+    size_t gap = 0;
+    for (size_t row = 0; row < rows.dates.size(); ++row) {
+        if (!rows.live[row]) {
+            if (++gap == LedgerParser::MAX_GAP) {
+                text += "#gap," + std::to_string(gap) + "\n";
+                gap = 0;
+            }
+            continue;
+        }
+        if (gap > 0) {
+            text += "#gap," + std::to_string(gap) + "\n";
+            gap = 0;
+        }
+        Transaction transaction(static_cast<TransactionType>(rows.types[row]), Money::fromCents(rows.cents[row]),
+                                rows.categories[row], rows.dates[row]);
+        BufferedLedgerWriter::formatLine(transaction, text);
+    }
+    // Trailing dead rows still hold ids that later appends must not reuse.
+    if (gap > 0) text += "#gap," + std::to_string(gap) + "\n";
+    return text;
+}
+
+// Up to length bytes of path from offset; false if it cannot be read.
+static bool readRange(const std::string& path, size_t offset, size_t length, std::string& bytes) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in || !in.seekg(static_cast<std::streamoff>(offset))) return false;
+    bytes.assign(length, '\0');
+    in.read(&bytes[0], static_cast<std::streamsize>(length));
+    bytes.resize(static_cast<size_t>(in.gcount()));
+    return true;
+}
+
+// Writes compacted plus everything after the copied rows into path + ".tmp"
+// and renames it over path. Other programs append without fileMutex(), so once
+// the temporary file is synced the ledger's size is checked again and any growth
+// copied across, until it holds still right before the rename. A writer that
+// keeps a descriptor open on the old file past the rename is out of reach.
+bool LedgerCompactor::swapIn(const std::string& path, const std::string& compacted, CompactionResult& result) {
+    std::string tempPath = path + ".tmp";
+    std::FILE* temp = std::fopen(tempPath.c_str(), "wb");
+    if (!temp) {
+        result.error = "could not write " + tempPath;
+        return false;
+    }
+
+    bool ok = std::fwrite(compacted.data(), 1, compacted.size(), temp) == compacted.size();
+    size_t copied = result.oldCovered;
+    for (int round = 0; ok; ++round) {
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(path, ec);
+        std::string tail;
+        if (ec || size < copied) {
+            result.error = path + " was rewritten meanwhile";
+            ok = false;
+        } else if (size == copied && round > 0) {
+            break;
+        } else if (round == 8) {
+            result.error = path + " kept growing";
+            ok = false;
+        } else if (!readRange(path, copied, static_cast<size_t>(size) - copied, tail)) {
+            result.error = "could not read " + path;
+            ok = false;
+        } else {
+            ok = std::fwrite(tail.data(), 1, tail.size(), temp) == tail.size() && syncFile(temp);
+            if (!ok) result.error = "could not write " + tempPath;
+            copied += tail.size();
+        }
+    }
+    ok = std::fclose(temp) == 0 && ok;
+
+    if (!ok || !replaceFile(tempPath, path)) {
+        if (ok) result.error = "could not replace " + path;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    result.bytesBefore = copied;
+    result.bytesAfter = compacted.size() + (copied - result.oldCovered);
+    return true;
+}
+
+// The slow part (formatting every row) runs without the lock; appends are only
+// held up while the lines written since the start are copied and the file swapped.
+void LedgerCompactor::run(std::string path, Rows rows, uint64_t covered, CompactionResult result) {
+    std::string contents = format(rows);
+    result.newCovered = contents.size();
+
+    {
+        std::lock_guard<std::mutex> lock(fileLock);
+        uint64_t sum = 0;
+        if (!checksumPrefix(path, result.oldCovered, sum) || sum != covered) {
+            result.error = path + " was rewritten meanwhile";
+        } else {
+            result.ok = swapIn(path, contents, result);
+        }
+
+        std::lock_guard<std::mutex> resultLock(resultMutex);
+        finished = std::move(result);
+    }
+    busy = false;
+}
@@ -0,0 +1,70 @@
+#ifndef LEDGERCOMPACTOR_H
+#define LEDGERCOMPACTOR_H
+#include "TransactionStore.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What one compaction did, for FinanceManager to fold into its own state.
+struct CompactionResult {
+    bool ok = false;
+    std::string error;
+    size_t oldCovered = 0;  // ledger bytes the copied rows stood for
+    size_t newCovered = 0;  // the same rows written out compactly
+    size_t removed = 0;     // TransactionStore::removedRows() when the copy was taken
+    size_t edits = 0;       // TransactionStore::editRecords() then
+    size_t bytesBefore = 0; // whole file before and after the swap
+    size_t bytesAfter = 0;
+};
+
+// Rewrites the text ledger without #delete and #replace records on a background
+// thread. The rows are copied when it starts; the thread writes each live row
+// as a plain line and each run of dead rows as one #gap line, so every id stays
+// where it was. Whatever was appended to the ledger meanwhile is copied across
+// verbatim at the end, under fileMutex(), which every append of ours holds too,
+// and the file is swapped atomically; lines other programs append right up to
+// the swap are carried over as well. If the copied part's bytes changed
+// meanwhile, another program rewrote the file and the compaction is dropped.
+class LedgerCompactor {
+public:
+    LedgerCompactor() = default;
+    ~LedgerCompactor();                 // waits for a running compaction
+    LedgerCompactor(const LedgerCompactor&) = delete;
+    LedgerCompactor& operator=(const LedgerCompactor&) = delete;
+
+    // Starts compacting path, whose first coveredBytes are what store holds. False if one is
+    // still running or its result has not been taken yet.
+    bool start(const std::string& path, const TransactionStore& store, size_t coveredBytes);
+    bool running() const { return busy; }
+    void wait();                        // until the running compaction (if any) is done
+    std::optional<CompactionResult> takeResult(); // the finished compaction not yet taken, if any
+
+    std::mutex& fileMutex() { return fileLock; } // hold while appending to the ledger
+
+private:
+    struct Rows {
+        std::vector<int32_t> dates;
+        std::vector<uint8_t> types;
+        std::vector<uint16_t> categories;
+        std::vector<int64_t> cents;
+        std::vector<uint8_t> live;
+    };
+
+    static std::string format(const Rows& rows); // the compacted text of rows
+    static bool checksumPrefix(const std::string& path, size_t bytes, uint64_t& sum); // false if shorter or unreadable
+    void run(std::string path, Rows rows, uint64_t covered, CompactionResult result);
+    static bool swapIn(const std::string& path, const std::string& compacted, CompactionResult& result); // caller holds fileLock
+
+    std::thread worker;
+    std::atomic<bool> busy{false};
+    std::mutex fileLock;                // the ledger file: appends and the final swap
+    std::mutex resultMutex;             // guards finished
+    std::optional<CompactionResult> finished;
+};
+
+#endif
@@ -0,0 +1,391 @@
+#include "LedgerDaemon.h"
+#include "PackedDate.h"
+#include "ThreadPool.h"
+#include "Validation.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static const size_t MAX_REQUEST_BYTES = 64 * 1024;
+
+LedgerDaemon::LedgerDaemon(FinanceManager& manager, std::string socketPath, unsigned workers)
+    : manager(manager), socketPath(std::move(socketPath)), workers(workers) {}
+
+// Fields of one request line.
+static std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) break;
+        start = tab + 1;
+    }
+    return fields;
+}
+
+// A transaction id: digits only.
+static bool parseId(const std::string& text, size_t& id) {
+    if (text.empty() || text.size() > 10 ||
+        !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; })) return false;
+    id = static_cast<size_t>(std::strtoull(text.c_str(), nullptr, 10));
+    return true;
+}
+
+// Checks a request and runs it: reads here under the shared lock, writes via the writer queue.
+std::string LedgerDaemon::execute(const std::vector<std::string>& f) {
+    const std::string& op = f[0];
+    size_t n = f.size();
+    Money amount;
+    size_t id = 0;
+
+    if (op == "stop" && n == 1) {
+        stopRequested = true;
+        return "OK\nStopping.\n";
+    }
+
+    if (op == "add") {
+        if (n != 5) return "ERR usage: add <income|expense> <amount> <category> <YYYY-MM-DD>\n";
+        if (f[1] != "income" && f[1] != "expense") return "ERR type must be income or expense\n";
+        if (!Money::parse(f[2], amount) || amount < Money()) return "ERR invalid amount\n";
+        if (!isValidCategory(f[1], f[3])) return "ERR unknown " + f[1] + " category\n";
+        if (!isValidDate(f[4])) return "ERR invalid date\n";
+    } else if (op == "edit") {
+        if (n != 6) return "ERR usage: edit <id> <income|expense> <amount> <category> <YYYY-MM-DD>\n";
+        if (!parseId(f[1], id)) return "ERR invalid id\n";
+        if (f[2] != "income" && f[2] != "expense") return "ERR type must be income or expense\n";
+        if (!Money::parse(f[3], amount) || amount < Money()) return "ERR invalid amount\n";
+        if (!isValidCategory(f[2], f[4])) return "ERR unknown " + f[2] + " category\n";
+        if (!isValidDate(f[5])) return "ERR invalid date\n";
+    } else if (op == "delete") {
+        if (n != 2 || !parseId(f[1], id)) return "ERR usage: delete <id>\n";
+    } else if (op == "budget" && n == 3) {
+        if (!isValidMonth(f[1])) return "ERR invalid month\n";
+        if (!Money::parse(f[2], amount) || amount < Money()) return "ERR invalid amount\n";
+    }
+
+    if (op == "add" || op == "edit" || op == "delete" || (op == "budget" && n == 3)) {
+        WriteJob job;
+        job.fields = f;
+        std::future<std::string> reply = job.reply.get_future();
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            writes.push_back(std::move(job));
+        }
+        queueChanged.notify_one();
+        return reply.get();
+    }
+
+    std::shared_lock<std::shared_mutex> lock(state);
+    std::ostringstream out;
+    if (op == "budget" && n == 2) {
+        if (!isValidMonth(f[1])) return "ERR invalid month\n";
+        out << "Budget for " << f[1] << ": $" << manager.getMonthlyBudget(f[1]) << "\n";
+        out << "Spent so far:    $" << manager.getMonthlyExpenseTotal(f[1]) << "\n";
+    } else if ((op == "report" || op == "chart") && n == 2) {
+        if (!isValidMonth(f[1])) return "ERR invalid month\n";
+        if (op == "report") manager.generateMonthlyReport(f[1], out);
+        else manager.showExpenseBarChart(f[1], out);
+    } else if (op == "range" && (n == 3 || n == 4)) {
+        if (!isValidMonth(f[1]) || !isValidMonth(f[2])) return "ERR invalid month\n";
+        ReportPeriod period = ReportPeriod::Month;
+        if (n == 4 && f[3] == "quarter") period = ReportPeriod::Quarter;
+        else if (n == 4 && f[3] == "year") period = ReportPeriod::Year;
+        else if (n == 4 && f[3] != "month") return "ERR period must be month, quarter or year\n";
+        manager.generateRangeReport(f[1], f[2], period, out);
+    } else if (op == "list" && n == 1) {
+        manager.loadTransactionsFromFile(out);
+    } else if (op == "category" && n >= 2) {
+        manager.filterTransactionsByCategories(std::vector<std::string>(f.begin() + 1, f.end()), out);
+    } else if (op == "date" && n == 2) {
+        if (!isValidDate(f[1])) return "ERR invalid date\n";
+        manager.filterTransactionsByDate(f[1], out);
+    } else if (op == "ids" && n == 2) {
+        if (!isValidDate(f[1])) return "ERR invalid date\n";
+        manager.showTransactionsWithIds(f[1], out);
+    } else if (op == "dates" && n == 3) {
+        if (!isValidDate(f[1]) || !isValidDate(f[2])) return "ERR invalid date\n";
+        manager.filterTransactionsByDateRange(std::min(f[1], f[2]), std::max(f[1], f[2]), out);
+    } else if (op == "amount" && (n == 3 || n == 4)) {
+        if (!Money::parse(f[1], amount) || amount < Money()) return "ERR invalid amount\n";
+        if (f[2] != "atleast" && f[2] != "atmost") return "ERR comparison must be atleast or atmost\n";
+        std::optional<TransactionType> type;
+        if (n == 4 && f[3] == "income") type = TransactionType::Income;
+        else if (n == 4 && f[3] == "expense") type = TransactionType::Expense;
+        else if (n == 4) return "ERR type must be income or expense\n";
+        manager.filterTransactionsByAmount(amount, f[2] == "atleast", type, out);
+    } else if (op == "top" && n >= 2 && n <= 4) {
+        size_t count = std::strtoul(f[1].c_str(), nullptr, 10);
+        if (count < 1 || count > TopAmounts::CAPACITY) return "ERR count must be 1 to 10\n";
+        std::string month = n >= 3 && f[2] != "all" ? f[2] : std::string();
+        if (!month.empty() && !isValidMonth(month)) return "ERR invalid month\n";
+        manager.showLargestExpenses(count, month, n == 4 ? f[3] : std::string(), out);
+    } else if (op == "sizes" && n <= 2) {
+        if (n == 2 && !isValidMonth(f[1])) return "ERR invalid month\n";
+        manager.showSpendingDistribution(n == 2 ? f[1] : std::string(), out);
+    } else if (op == "budgets" && n == 1) {
+        manager.showBudgetReport(out);
+    } else {
+        return "ERR unknown request: " + op + "\n";
+    }
+    return "OK\n" + out.str();
+}
+
+// Applies one checked write with every reader locked out, the same way the menu does.
+std::string LedgerDaemon::write(const std::vector<std::string>& f) {
+    std::unique_lock<std::shared_mutex> lock(state);
+    std::ostringstream out;
+    Money amount;
+
+    if (f[0] == "edit" || f[0] == "delete") {
+        size_t id = 0;
+        parseId(f[1], id);
+        bool ok;
+        if (f[0] == "delete") {
+            ok = manager.deleteTransaction(id, out);
+        } else {
+            Money::parse(f[3], amount);
+            ok = manager.replaceTransaction(id, Transaction(f[2], amount, f[4], f[5]), out);
+        }
+        std::string text = out.str();
+        if (ok) return "OK\n" + text;
+        if (text.rfind("Error: ", 0) == 0) text.erase(0, 7);
+        return "ERR " + text;
+    }
+
+    Money::parse(f[2], amount);
+    if (f[0] == "budget") {
+        manager.setMonthlyBudget(f[1], amount, out);
+        return "OK\n" + out.str();
+    }
+
+    Transaction t(f[1], amount, f[3], f[4]);
+    manager.saveTransactionToFile(t, out);
+    if (f[1] == "expense") {
+        std::string month = f[4].substr(0, 7);
+        Money total = manager.getMonthlyExpenseTotal(month);
+        Money budget = manager.getMonthlyBudget(month);
+        if (budget > Money() && total > budget) {
+            out << "Budget of $" << budget << " exceeded for " << month << ".\n";
+        }
+    }
+    return "OK\n" + out.str();
+}
+
+// The only thread that changes the manager. Between writes it checks every
+// 250 ms for lines other programs appended to the files.
+void LedgerDaemon::writerLoop() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        queueChanged.wait_for(lock, std::chrono::milliseconds(250),
+                              [this] { return writerStopping || !writes.empty(); });
+        while (!writes.empty()) {
+            WriteJob job = std::move(writes.front());
+            writes.pop_front();
+            lock.unlock();
+            job.reply.set_value(write(job.fields));
+            lock.lock();
+        }
+        if (writerStopping) return;
+
+        lock.unlock();
+        {
+            std::unique_lock<std::shared_mutex> exclusive(state);
+            manager.refresh(std::cout);
+        }
+        lock.lock();
+    }
+}
+
+#ifdef _WIN32
+
+bool LedgerDaemon::run(std::string& error) {
+    error = "daemon mode needs Unix domain sockets, which this build does not support";
+    return false;
+}
+
+bool LedgerDaemon::request(const std::string&, const std::vector<std::string>&, std::ostream&, std::string& error) {
+    error = "daemon mode needs Unix domain sockets, which this build does not support";
+    return false;
+}
+
+void LedgerDaemon::serve(int) {}
+
+#else
+
+static volatile std::sig_atomic_t signalled = 0;
+
+static void onSignal(int) {
+    signalled = 1;
+}
+
+// Connected socket for path, or -1.
+static int connectTo(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) return -1;
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, path.size());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Reads one request line (a client that stalls for 5 s is dropped), answers it and hangs up.
+void LedgerDaemon::serve(int client) {
+    timeval timeout{5, 0};
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string line;
+    char buffer[4096];
+    while (line.find('\n') == std::string::npos && line.size() < MAX_REQUEST_BYTES) {
+        ssize_t n = ::recv(client, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        line.append(buffer, static_cast<size_t>(n));
+    }
+
+    std::string reply;
+    size_t end = line.find('\n');
+    if (end == std::string::npos) {
+        reply = "ERR incomplete request\n";
+    } else {
+        line.resize(end);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        reply = execute(splitFields(line));
+    }
+    sendAll(client, reply);
+    ::close(client);
+}
+
+bool LedgerDaemon::run(std::string& error) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        error = "socket path is too long: " + socketPath;
+        return false;
+    }
+
+    // A socket file left behind by a daemon that died is replaced; a live daemon is not.
+    int probe = connectTo(socketPath);
+    if (probe >= 0) {
+        ::close(probe);
+        error = "a daemon is already listening on " + socketPath;
+        return false;
+    }
+    ::unlink(socketPath.c_str());
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    address.sun_family = AF_UNIX;
+    socketPath.copy(address.sun_path, socketPath.size());
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, 64) != 0) {
+        error = "could not listen on " + socketPath;
+        if (listener >= 0) ::close(listener);
+        return false;
+    }
+
+    manager.setAutoRefresh(false); // the writer thread refreshes, with readers locked out
+    manager.waitUntilLoaded();
+    stopRequested = false;
+    signalled = 0;
+    auto previousInt = std::signal(SIGINT, onSignal);
+    auto previousTerm = std::signal(SIGTERM, onSignal);
+    auto previousPipe = std::signal(SIGPIPE, SIG_IGN); // a client that hangs up early only fails its own send
+    std::cout << "Serving " << socketPath << " (stop with Ctrl+C or a stop request).\n" << std::flush;
+
+    std::thread writer(&LedgerDaemon::writerLoop, this);
+    {
+        ThreadPool pool(workers);
+        while (!stopRequested && !signalled) {
+            pollfd ready{listener, POLLIN, 0};
+            if (::poll(&ready, 1, 250) <= 0) continue; // timeout, or a signal arrived
+            int client = ::accept(listener, nullptr, nullptr);
+            if (client >= 0) pool.submit([this, client] { serve(client); });
+        }
+        ::close(listener);
+        ::unlink(socketPath.c_str());
+    } // the pool finishes requests already accepted, which may still need the writer
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        writerStopping = true;
+    }
+    queueChanged.notify_one();
+    writer.join();
+
+    std::signal(SIGINT, previousInt);
+    std::signal(SIGTERM, previousTerm);
+    std::signal(SIGPIPE, previousPipe);
+    manager.saveSnapshot();
+    std::cout << "Daemon stopped.\n";
+    return true;
+}
+
+bool LedgerDaemon::request(const std::string& socketPath, const std::vector<std::string>& fields,
+                           std::ostream& out, std::string& error) {
+    std::string line;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (fields[i].find_first_of("\t\n") != std::string::npos) {
+            error = "request fields cannot contain tabs or newlines";
+            return false;
+        }
+        line += (i > 0 ? "\t" : "") + fields[i];
+    }
+    line += '\n';
+
+    int fd = connectTo(socketPath);
+    if (fd < 0) {
+        error = "no daemon is listening on " + socketPath;
+        return false;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    if (!sendAll(fd, line)) {
+        ::close(fd);
+        error = "could not send the request";
+        return false;
+    }
+    ::shutdown(fd, SHUT_WR);
+
+    std::string reply;
+    char buffer[65536];
+    ssize_t n;
+    while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) reply.append(buffer, static_cast<size_t>(n));
+    ::close(fd);
+
+    size_t end = reply.find('\n');
+    std::string status = reply.substr(0, end);
+    if (status == "OK") {
+        out << reply.substr(end + 1);
+        return true;
+    }
+    error = status.rfind("ERR ", 0) == 0 ? status.substr(4) : "the daemon closed the connection without answering";
+    return false;
+}
+
+#endif
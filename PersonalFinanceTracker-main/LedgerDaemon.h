@@ -0,0 +1,77 @@
+#ifndef LEDGERDAEMON_H
+#define LEDGERDAEMON_H
+#include "FinanceManager.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// Keeps one FinanceManager loaded and answers requests from other processes
+// over a Unix domain socket, so they neither re-parse the ledger nor race on
+// appends to it.
+//
+// Protocol: one request per connection. The client sends one line of
+// tab-separated fields, the first naming the operation, and reads until the
+// daemon closes the connection. The reply starts with "OK\n" or
+// "ERR <reason>\n", followed by the operation's usual output.
+//   add <income|expense> <amount> <category> <YYYY-MM-DD>
+//   edit <id> <income|expense> <amount> <category> <YYYY-MM-DD>   replace a transaction, keeping its id
+//   delete <id>
+//   ids <YYYY-MM-DD>                 a day's transactions with their ids
+//   budget <YYYY-MM> <amount>        set a budget
+//   budget <YYYY-MM>                 budget and spending so far
+//   report <YYYY-MM>                 chart <YYYY-MM>
+//   range <YYYY-MM> <YYYY-MM> [month|quarter|year]
+//   list                             category <name>...
+//   date <YYYY-MM-DD>                dates <YYYY-MM-DD> <YYYY-MM-DD>
+//   amount <n> <atleast|atmost> [income|expense]
+//   top <n> [YYYY-MM|all] [category]  largest expenses (n up to 10)
+//   sizes [YYYY-MM]                  median/p90/p99 expense per category
+//   budgets                          budget vs actual for every month (csv when started with --format csv)
+//   stop                             shut the daemon down
+//
+// Reads run concurrently on a pool of workers, each holding a shared lock for
+// the whole request so it sees the state between two writes. Writes (add, edit,
+// delete, budget set) go through a queue to a single writer thread that takes the lock
+// exclusively; it also applies changes other programs make to the files.
+class LedgerDaemon {
+public:
+    LedgerDaemon(FinanceManager& manager, std::string socketPath, unsigned workers = 0);
+
+    // Serves until a stop request or SIGINT/SIGTERM. False with error if the socket cannot be set up.
+    bool run(std::string& error);
+
+    // Client side: sends one request and copies the reply (after the status line) to out.
+    // False with error if the daemon cannot be reached or answered ERR.
+    static bool request(const std::string& socketPath, const std::vector<std::string>& fields,
+                        std::ostream& out, std::string& error);
+
+private:
+    struct WriteJob {
+        std::vector<std::string> fields;
+        std::promise<std::string> reply;
+    };
+
+    void serve(int client);                                      // one connection, on a pool worker
+    std::string execute(const std::vector<std::string>& fields); // status line + output
+    std::string write(const std::vector<std::string>& fields);   // runs on the writer thread
+    void writerLoop();
+
+    FinanceManager& manager;
+    std::string socketPath;
+    unsigned workers;
+
+    std::shared_mutex state;                  // readers shared, the writer exclusive
+    std::mutex queueMutex;                    // guards writes and writerStopping
+    std::condition_variable queueChanged;
+    std::deque<WriteJob> writes;
+    bool writerStopping = false;
+    std::atomic<bool> stopRequested{false};
+};
+
+#endif
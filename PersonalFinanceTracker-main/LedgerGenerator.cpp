@@ -0,0 +1,128 @@
+#include "LedgerGenerator.h"
+#include "BufferedLedgerWriter.h"
+#include "CategoryPool.h"
+#include <cstdio>     // std::remove
+
+namespace {
+
+// One category with its share of rows (out of the table total) and amount range in cents.
+struct CategoryProfile {
+    const char* name;
+    TransactionType type;
+    uint32_t weight;
+    int64_t minCents;
+    int64_t maxCents;
+};
+
+// Same names as the menus in main.cpp.
+const CategoryProfile PROFILES[] = {
+    {"Groceries",     TransactionType::Expense, 220,   1500,  25000},
+    {"Eating Out",    TransactionType::Expense, 160,    800,   9000},
+    {"Transport",     TransactionType::Expense, 140,    250,   8000},
+    {"Shopping",      TransactionType::Expense,  80,   1000,  40000},
+    {"Bills",         TransactionType::Expense,  60,   3000,  30000},
+    {"Entertainment", TransactionType::Expense,  50,    500,  12000},
+    {"Personal Care", TransactionType::Expense,  30,    800,   8000},
+    {"General",       TransactionType::Expense,  30,    200,   5000},
+    {"Transfers",     TransactionType::Expense,  25,   5000, 100000},
+    {"Family",        TransactionType::Expense,  20,   1000,  20000},
+    {"Savings",       TransactionType::Expense,  20,  10000,  80000},
+    {"Expenses",      TransactionType::Expense,  15,    500,  15000},
+    {"Finances",      TransactionType::Expense,  10,   1000,  20000},
+    {"Gifts",         TransactionType::Expense,  10,   1500,  15000},
+    {"Charity",       TransactionType::Expense,   8,    500,  10000},
+    {"Holidays",      TransactionType::Expense,   5,  20000, 300000},
+    {"Salary",        TransactionType::Income,   60, 150000, 450000},
+    {"Freelance",     TransactionType::Income,   25,   5000,  90000},
+    {"Investments",   TransactionType::Income,   10,    500,  50000},
+    {"Gifts",         TransactionType::Income,    5,   1000,  20000},
+    {"Other",         TransactionType::Income,    7,    100,  10000},
+};
+
+const int DAYS_IN_MONTH[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int daysInYear(int year) {
+    return isLeapYear(year) ? 366 : 365;
+}
+
+} // namespace
+
+LedgerGenerator::LedgerGenerator(uint64_t rows, uint64_t seed, int firstYear, int years)
+    : rows(rows), state(seed), firstYear(firstYear), days(0) {
+    for (int y = firstYear; y < firstYear + years; ++y) days += daysInYear(y);
+    for (const CategoryProfile& profile : PROFILES) {
+        categoryIds.push_back(CategoryPool::intern(std::string_view(profile.name)));
+        totalWeight += profile.weight;
+    }
+}
+
+uint64_t LedgerGenerator::random() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t LedgerGenerator::below(uint64_t bound) {
+    return bound == 0 ? 0 : random() % bound;
+}
+
+// Day number (0 = 1 January of firstYear) -> packed date.
+int32_t LedgerGenerator::dateForDay(int64_t day) const {
+    int year = firstYear;
+    while (day >= daysInYear(year)) day -= daysInYear(year++);
+
+    int month = 0;
+    while (true) {
+        int length = DAYS_IN_MONTH[month] + (month == 1 && isLeapYear(year) ? 1 : 0);
+        if (day < length) break;
+        day -= length;
+        ++month;
+    }
+    return year * 512 + (month + 1) * 32 + static_cast<int32_t>(day) + 1;
+}
+
+Transaction LedgerGenerator::next() {
+    // Spread rows evenly over the period; about 2% are entered late.
+    int64_t day = rows > 0 ? static_cast<int64_t>(row * static_cast<uint64_t>(days) / rows) : 0;
+    if (below(50) == 0) {
+        day -= static_cast<int64_t>(below(31));
+        if (day < 0) day = 0;
+    }
+
+    uint64_t pick = below(totalWeight);
+    size_t c = 0;
+    while (pick >= PROFILES[c].weight) pick -= PROFILES[c++].weight;
+    const CategoryProfile& profile = PROFILES[c];
+
+    // Skew amounts toward the low end of the range, like real receipts.
+    uint64_t span = static_cast<uint64_t>(profile.maxCents - profile.minCents);
+    uint64_t a = below(span + 1), b = below(span + 1);
+    int64_t cents = profile.minCents + static_cast<int64_t>(a < b ? a : b);
+
+    ++row;
+    return Transaction(profile.type, Money::fromCents(cents), categoryIds[c], dateForDay(day));
+}
+
+bool LedgerGenerator::writeText(const std::string& path, uint64_t rows, uint64_t seed, std::string& error) {
+    std::remove(path.c_str());
+
+    BufferedLedgerWriter writer;
+    if (!writer.open(path)) {
+        error = "could not open " + path;
+        return false;
+    }
+
+    LedgerGenerator generator(rows, seed);
+    while (generator.index() < rows) writer.append(generator.next());
+
+    if (!writer.close()) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
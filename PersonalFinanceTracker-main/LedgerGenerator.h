@@ -0,0 +1,38 @@
+#ifndef LEDGERGENERATOR_H
+#define LEDGERGENERATOR_H
+#include "Transaction.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Produces synthetic ledgers of any size for benchmarking. The same seed and
+// row count always give the same file, on every compiler (no std::
+// distributions are used). Rows run over ten years in date order, with a few
+// entries back-dated by up to a month, and categories follow a household-like
+// mix: many groceries and eating out, monthly bills and salary, rare holidays.
+class LedgerGenerator {
+public:
+    explicit LedgerGenerator(uint64_t rows, uint64_t seed = 42, int firstYear = 2016, int years = 10);
+
+    Transaction next();            // row number index(), then advances
+    uint64_t index() const { return row; }
+    uint64_t size() const { return rows; }
+
+    // Writes a whole "date,type,category,amount" ledger to path, replacing it. Returns false on an I/O error.
+    static bool writeText(const std::string& path, uint64_t rows, uint64_t seed, std::string& error);
+
+private:
+    uint64_t random();             // splitmix64
+    uint64_t below(uint64_t bound); // 0 <= r < bound
+    int32_t dateForDay(int64_t day) const;
+
+    uint64_t rows;
+    uint64_t state;
+    uint64_t row = 0;
+    int firstYear;
+    int64_t days;                  // days covered by the ledger
+    std::vector<uint16_t> categoryIds; // CategoryPool id of each profile
+    uint32_t totalWeight = 0;
+};
+
+#endif
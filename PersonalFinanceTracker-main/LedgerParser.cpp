@@ -0,0 +1,133 @@
+#include "LedgerParser.h"
+#include "PackedDate.h"
+#include "Profiler.h"
+#include <charconv>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LEDGER_PARSER_SSE2 1
+#endif
+
+LedgerParser::LedgerParser(size_t bufferSize) : buffer(bufferSize < 64 ? 64 : bufferSize) {}
+
+// Fills the rest of the buffer from the file. Grows the buffer when a single line does not fit.
+bool LedgerParser::readBlock(std::FILE* file, size_t& filled, bool& atEnd) {
+    if (filled == buffer.size()) buffer.resize(buffer.size() * 2);
+
+    size_t got = std::fread(buffer.data() + filled, 1, buffer.size() - filled, file);
+    filled += got;
+    Profiler::count(Profiler::Counter::BytesRead, got);
+    if (got == 0 || std::feof(file)) atEnd = true;
+    return !std::ferror(file);
+}
+
+// Scans 16 bytes at a time for c, falling back to a plain loop for the tail.
+const char* LedgerParser::findByte(const char* p, const char* end, char c) {
+#ifdef LEDGER_PARSER_SSE2
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask != 0) return p + __builtin_ctz(static_cast<unsigned>(mask));
+        p += 16;
+    }
+#endif
+    while (p < end && *p != c) ++p;
+    return p;
+}
+
+bool LedgerParser::parseLine(std::string_view line, LedgerRow& row, std::string& error) {
+    if (!line.empty() && line[0] == '#') return parseRecord(line.substr(1), row, error);
+    row.kind = LedgerRowKind::Transaction;
+    return parseTransaction(line, row, error);
+}
+
+// "delete,<id>", "replace,<id>,<transaction>" or "gap,<count>".
+bool LedgerParser::parseRecord(std::string_view line, LedgerRow& row, std::string& error) {
+    size_t comma = line.find(',');
+    std::string_view keyword = line.substr(0, comma);
+    if (keyword == "delete") row.kind = LedgerRowKind::Delete;
+    else if (keyword == "replace") row.kind = LedgerRowKind::Replace;
+    else if (keyword == "gap") row.kind = LedgerRowKind::Gap;
+    else {
+        error = "unknown record";
+        return false;
+    }
+    if (comma == std::string_view::npos) {
+        error = "missing id";
+        return false;
+    }
+
+    const char* begin = line.data() + comma + 1;
+    const char* end = line.data() + line.size();
+    auto result = std::from_chars(begin, end, row.target);
+    if (result.ec != std::errc() || result.ptr == begin) {
+        error = "bad id";
+        return false;
+    }
+    if (row.kind != LedgerRowKind::Replace) {
+        if (result.ptr != end) {
+            error = "unexpected text after id";
+            return false;
+        }
+        if (row.kind == LedgerRowKind::Gap && (row.target == 0 || row.target > MAX_GAP)) {
+            error = "gap out of range";
+            return false;
+        }
+        return true;
+    }
+    if (result.ptr == end || *result.ptr != ',') {
+        error = "missing replacement";
+        return false;
+    }
+    return parseTransaction(std::string_view(result.ptr + 1, static_cast<size_t>(end - result.ptr - 1)), row, error);
+}
+
+// Splits "date,type,category,amount", checks the date and type and converts the amount without allocating.
+bool LedgerParser::parseTransaction(std::string_view line, LedgerRow& row, std::string& error) {
+    const char* p = line.data();
+    const char* end = p + line.size();
+    std::string_view fields[4];
+
+    for (int i = 0; i < 3; ++i) {
+        const char* comma = findByte(p, end, ',');
+        if (comma == end) {
+            error = "expected 4 comma-separated fields";
+            return false;
+        }
+        fields[i] = std::string_view(p, static_cast<size_t>(comma - p));
+        p = comma + 1;
+    }
+    fields[3] = std::string_view(p, static_cast<size_t>(end - p));
+
+    if (!packDate(fields[0], row.packedDate)) {
+        error = "bad date";
+        return false;
+    }
+
+    if (fields[1] == "expense") {
+        row.transactionType = TransactionType::Expense;
+    } else if (fields[1] == "income") {
+        row.transactionType = TransactionType::Income;
+    } else {
+        error = "bad type";
+        return false;
+    }
+
+    if (fields[3].empty()) {
+        error = "missing amount";
+        return false;
+    }
+
+    Money amount;
+    if (!Money::parse(fields[3], amount)) {
+        error = "bad amount";
+        return false;
+    }
+
+    row.date = fields[0];
+    row.type = fields[1];
+    row.category = fields[2];
+    row.amount = amount;
+    return true;
+}
@@ -0,0 +1,142 @@
+#ifndef LEDGERPARSER_H
+#define LEDGERPARSER_H
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "Transaction.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// What a ledger line records. A transaction's id is its position among the
+// transaction lines of the ledger, readable or not; lines starting with '#'
+// change an earlier row by id instead of adding one, so a correction is a small append.
+enum class LedgerRowKind : uint8_t {
+    Transaction, // date,type,category,amount: the next id
+    Delete,      // #delete,<id>
+    Replace,     // #replace,<id>,date,type,category,amount: the same id with new contents
+    Gap,         // #gap,<count>: ids of rows that compaction removed, so later ids stay put (count <= MAX_GAP)
+    Unreadable   // a transaction line that did not parse (also reported as an error): it still
+                 // holds the next id, so fixing it by hand later does not move the ids after it
+};
+
+// One parsed ledger line. The views point into the parser's read buffer and
+// are only valid inside the row callback.
+struct LedgerRow {
+    LedgerRowKind kind = LedgerRowKind::Transaction;
+    uint32_t target = 0;                                  // Delete/Replace: row id, Gap: how many ids
+    std::string_view text;                                // the whole line, for error messages
+    std::string_view date;
+    std::string_view type;
+    std::string_view category;
+    Money amount;
+    int32_t packedDate = 0;                               // date, already validated and packed
+    TransactionType transactionType = TransactionType::Expense;
+    size_t lineNumber = 0;                                // 1-based line in the input
+};
+
+// A line that could not be parsed, reported instead of throwing.
+struct ParseError {
+    size_t lineNumber;    // 1-based line in the file
+    std::string message;  // what was wrong
+    std::string text;     // the offending line
+};
+
+// Fast parser for the "date,type,category,amount" ledger format.
+// Reads the file in large blocks, finds delimiters with a vectorized scan and
+// converts amounts straight to Money (std::from_chars, no double), so no per-line allocation happens.
+class LedgerParser {
+public:
+    explicit LedgerParser(size_t bufferSize = 1 << 20);
+
+    // Parses a whole file, calling onRow for every valid line and every unreadable transaction line. Returns false if the file could not be opened.
+    template <typename RowFn>
+    bool parseFile(const std::string& path, RowFn&& onRow, std::vector<ParseError>& errors);
+
+    // Parses complete lines in [data, data + size). Returns the number of bytes consumed,
+    // which stops before a trailing line with no newline unless atEnd is true.
+    template <typename RowFn>
+    static size_t parseBuffer(const char* data, size_t size, bool atEnd, size_t& lineNumber,
+                              RowFn&& onRow, std::vector<ParseError>& errors);
+
+    // Splits and converts a single line (without its newline), a transaction or a '#' record.
+    // On failure fills error and returns false.
+    static bool parseLine(std::string_view line, LedgerRow& row, std::string& error);
+
+    // Largest #gap,<count> accepted. Compaction splits longer runs of dead rows,
+    // so a larger count is a corrupt line, not something to allocate rows for.
+    static const uint32_t MAX_GAP = 1 << 16;
+
+    // First occurrence of c in [p, end), or end. Uses SSE2 where available.
+    static const char* findByte(const char* p, const char* end, char c);
+
+private:
+    static bool parseTransaction(std::string_view line, LedgerRow& row, std::string& error);
+    static bool parseRecord(std::string_view line, LedgerRow& row, std::string& error); // after the '#'
+
+    bool readBlock(std::FILE* file, size_t& filled, bool& atEnd); // top up the buffer from file
+
+    std::vector<char> buffer;
+};
+
+template <typename RowFn>
+size_t LedgerParser::parseBuffer(const char* data, size_t size, bool atEnd, size_t& lineNumber,
+                                 RowFn&& onRow, std::vector<ParseError>& errors) {
+    const char* p = data;
+    const char* end = data + size;
+    LedgerRow row;
+    std::string error;
+
+    while (p < end) {
+        const char* nl = findByte(p, end, '\n');
+        if (nl == end && !atEnd) break; // incomplete line, wait for more data
+
+        std::string_view line(p, static_cast<size_t>(nl - p));
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        ++lineNumber;
+
+        if (!line.empty()) {
+            row.lineNumber = lineNumber;
+            row.text = line;
+            if (parseLine(line, row, error)) {
+                onRow(row);
+            } else {
+                errors.push_back({lineNumber, error, std::string(line)});
+                if (line[0] != '#') {
+                    row.kind = LedgerRowKind::Unreadable;
+                    onRow(row);
+                }
+            }
+        }
+
+        p = (nl == end) ? end : nl + 1;
+    }
+
+    return static_cast<size_t>(p - data);
+}
+
+template <typename RowFn>
+bool LedgerParser::parseFile(const std::string& path, RowFn&& onRow, std::vector<ParseError>& errors) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    size_t filled = 0;
+    size_t lineNumber = 0;
+    bool atEnd = false;
+
+    while (!atEnd) {
+        if (!readBlock(file, filled, atEnd)) break;
+
+        size_t used = parseBuffer(buffer.data(), filled, atEnd, lineNumber, onRow, errors);
+
+        // Keep the unfinished line at the front of the buffer for the next block.
+        filled -= used;
+        if (filled > 0) std::memmove(buffer.data(), buffer.data() + used, filled);
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+#endif
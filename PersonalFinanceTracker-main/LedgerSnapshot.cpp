@@ -0,0 +1,270 @@
+#include "LedgerSnapshot.h"
+#include "AtomicFile.h"
+#include "CategoryPool.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char SNAPSHOT_MAGIC[8] = {'P', 'F', 'T', 'S', 'N', 'A', 'P', 'S'};
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+
+static uint64_t rotateLeft(uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+static uint64_t mixLane(uint64_t lane, uint64_t word) {
+    return rotateLeft(lane + word * PRIME2, 31) * PRIME1;
+}
+
+uint64_t LedgerSnapshot::checksum(const char* data, size_t size) {
+    uint64_t lanes[4] = {PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            std::memcpy(&word, data + i + lane * 8, 8);
+            lanes[lane] = mixLane(lanes[lane], word);
+        }
+    }
+
+    uint64_t hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) +
+                    rotateLeft(lanes[3], 18) + size;
+    for (; i < size; ++i) {
+        hash = rotateLeft(hash ^ (static_cast<uint8_t>(data[i]) * PRIME1), 11) * PRIME2;
+    }
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+// Small helpers for the length-prefixed parts.
+template <typename T>
+static bool writeValue(std::FILE* file, const T& value) {
+    return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+static bool writeArray(std::FILE* file, const std::vector<T>& values) {
+    return values.empty() || std::fwrite(values.data(), sizeof(T), values.size(), file) == values.size();
+}
+
+static bool writeText(std::FILE* file, const std::string& text) {
+    uint32_t length = static_cast<uint32_t>(text.size());
+    return writeValue(file, length) && (length == 0 || std::fwrite(text.data(), 1, length, file) == length);
+}
+
+bool LedgerSnapshot::save(const std::string& path, const char* ledgerData, size_t ledgerBytes,
+                          const TransactionStore& store, const DateIndex& dateIndex,
+                          const AggregateTable& aggregates, std::string& error) {
+    if (ledgerBytes > 0 && ledgerData[ledgerBytes - 1] != '\n') {
+        error = "ledger does not end with a newline";
+        return false;
+    }
+
+    // Only the categories the rows use, renumbered densely.
+    std::vector<uint16_t> remap(CategoryPool::size(), UINT16_MAX);
+    std::vector<uint16_t> categories;
+    categories.reserve(store.size());
+    std::vector<std::string_view> names;
+    auto snapshotId = [&](uint16_t id) {
+        if (remap[id] == UINT16_MAX) {
+            remap[id] = static_cast<uint16_t>(names.size());
+            names.push_back(CategoryPool::name(id));
+        }
+        return remap[id];
+    };
+    for (uint16_t id : store.categories()) categories.push_back(snapshotId(id));
+
+    std::vector<AggregateEntry> totals = aggregates.entries();
+    for (AggregateEntry& entry : totals) entry.category = snapshotId(entry.category);
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.byteOrder = 0x01020304;
+    header.ledgerBytes = ledgerBytes;
+    header.ledgerLines = static_cast<uint64_t>(std::count(ledgerData, ledgerData + ledgerBytes, '\n'));
+    header.ledgerChecksum = checksum(ledgerData, ledgerBytes);
+    header.rowCount = store.size();
+    header.categoryCount = static_cast<uint32_t>(names.size());
+    header.errorCount = store.loadErrors().size();
+    header.removedRows = store.removedRows();
+    header.editRecords = store.editRecords();
+
+    std::string tempPath = path + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        error = "could not create " + tempPath;
+        return false;
+    }
+
+    bool ok = writeValue(file, header);
+    for (std::string_view name : names) {
+        uint16_t length = static_cast<uint16_t>(name.size());
+        ok = ok && writeValue(file, length) && std::fwrite(name.data(), 1, length, file) == length;
+    }
+    ok = ok && writeArray(file, store.dates()) && writeArray(file, store.types()) &&
+         writeArray(file, categories) && writeArray(file, store.cents()) && writeArray(file, store.live()) &&
+         writeArray(file, dateIndex.order());
+    for (const ParseError& e : store.loadErrors()) {
+        ok = ok && writeValue(file, static_cast<uint64_t>(e.lineNumber)) &&
+             writeText(file, e.message) && writeText(file, e.text);
+    }
+    ok = ok && writeValue(file, static_cast<uint64_t>(totals.size()));
+    for (const AggregateEntry& entry : totals) {
+        ok = ok && writeValue(file, entry.month) && writeValue(file, entry.category) &&
+             writeValue(file, entry.income) && writeValue(file, entry.expense);
+    }
+    ok = ok && syncFile(file);
+    ok = std::fclose(file) == 0 && ok;
+
+    if (!ok || !replaceFile(tempPath, path)) {
+        std::remove(tempPath.c_str());
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+// Bounds-checked reader over the mapped snapshot.
+class SnapshotCursor {
+public:
+    SnapshotCursor(const char* data, size_t size) : p(data), end(data + size) {}
+
+    template <typename T>
+    bool value(T& out) {
+        if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+        std::memcpy(&out, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    bool array(std::vector<T>& out, size_t count) {
+        if (static_cast<size_t>(end - p) / sizeof(T) < count) return false;
+        out.resize(count);
+        if (count > 0) std::memcpy(out.data(), p, count * sizeof(T));
+        p += count * sizeof(T);
+        return true;
+    }
+
+    bool text(std::string& out, size_t length) {
+        if (static_cast<size_t>(end - p) < length) return false;
+        out.assign(p, length);
+        p += length;
+        return true;
+    }
+
+private:
+    const char* p;
+    const char* end;
+};
+
+bool LedgerSnapshot::load(const std::string& path, const char* ledgerData, size_t ledgerBytes,
+                          TransactionStore& store, DateIndex& dateIndex, AggregateTable& aggregates,
+                          size_t& coveredBytes, size_t& coveredLines, std::string& reason) {
+    MappedFile file;
+    if (!file.open(path)) {
+        reason = "no snapshot";
+        return false;
+    }
+
+    SnapshotCursor in(file.data(), file.size());
+    SnapshotHeader header;
+    if (!in.value(header) || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != VERSION || header.byteOrder != 0x01020304) {
+        reason = "snapshot is from another version";
+        return false;
+    }
+    if (header.ledgerBytes > ledgerBytes) {
+        reason = "ledger was truncated";
+        return false;
+    }
+    if (checksum(ledgerData, static_cast<size_t>(header.ledgerBytes)) != header.ledgerChecksum) {
+        reason = "ledger was edited";
+        return false;
+    }
+
+    std::vector<uint16_t> remap;
+    for (uint32_t i = 0; i < header.categoryCount; ++i) {
+        uint16_t length = 0;
+        std::string name;
+        if (!in.value(length) || !in.text(name, length)) {
+            reason = "snapshot is damaged";
+            return false;
+        }
+        remap.push_back(CategoryPool::intern(std::move(name)));
+    }
+
+    size_t rows = static_cast<size_t>(header.rowCount);
+    std::vector<int32_t> dates;
+    std::vector<uint8_t> types;
+    std::vector<uint16_t> categories;
+    std::vector<int64_t> cents;
+    std::vector<uint8_t> live;
+    std::vector<uint32_t> order;
+    if (!in.array(dates, rows) || !in.array(types, rows) || !in.array(categories, rows) ||
+        !in.array(cents, rows) || !in.array(live, rows) ||
+        !in.array(order, static_cast<size_t>(std::count(live.begin(), live.end(), 1)))) {
+        reason = "snapshot is damaged";
+        return false;
+    }
+
+    std::vector<ParseError> errors;
+    for (uint64_t i = 0; i < header.errorCount; ++i) {
+        uint64_t line = 0;
+        uint32_t length = 0;
+        ParseError e;
+        if (!in.value(line) || !in.value(length) || !in.text(e.message, length) ||
+            !in.value(length) || !in.text(e.text, length)) {
+            reason = "snapshot is damaged";
+            return false;
+        }
+        e.lineNumber = static_cast<size_t>(line);
+        errors.push_back(std::move(e));
+    }
+
+    uint64_t entryCount = 0;
+    if (!in.value(entryCount)) {
+        reason = "snapshot is damaged";
+        return false;
+    }
+    std::vector<AggregateEntry> totals;
+    for (uint64_t i = 0; i < entryCount; ++i) {
+        AggregateEntry entry;
+        if (!in.value(entry.month) || !in.value(entry.category) || !in.value(entry.income) ||
+            !in.value(entry.expense) || entry.category >= remap.size()) {
+            reason = "snapshot is damaged";
+            return false;
+        }
+        entry.category = remap[entry.category];
+        totals.push_back(entry);
+    }
+
+    for (uint16_t& id : categories) {
+        if (id >= remap.size()) {
+            reason = "snapshot is damaged";
+            return false;
+        }
+        id = remap[id];
+    }
+
+    store.clear();
+    store.appendColumns(dates, types, categories, cents, live);
+    store.restoreEditCounts(static_cast<size_t>(header.removedRows), static_cast<size_t>(header.editRecords));
+    if (!dateIndex.restore(store.dates(), store.live(), std::move(order))) {
+        store.clear();
+        reason = "snapshot is damaged";
+        return false;
+    }
+    store.finishLoad(std::move(errors));
+    aggregates.clear();
+    for (const AggregateEntry& entry : totals) aggregates.addEntry(entry);
+
+    coveredBytes = static_cast<size_t>(header.ledgerBytes);
+    coveredLines = static_cast<size_t>(header.ledgerLines);
+    return true;
+}
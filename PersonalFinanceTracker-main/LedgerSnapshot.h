@@ -0,0 +1,61 @@
+#ifndef LEDGERSNAPSHOT_H
+#define LEDGERSNAPSHOT_H
+#include "AggregateTable.h"
+#include "DateIndex.h"
+#include "LedgerParser.h"
+#include "TransactionStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk layout of data/snapshot.bin (little-endian):
+//   SnapshotHeader
+//   categoryCount names, each a uint16_t length then the bytes
+//   rowCount dates (int32), types (uint8), category ids (uint16), cents (int64), live flags (uint8)
+//   one uint32 row id per live row, in DateIndex order
+//   errorCount skipped lines: uint64 line, uint32 length + message, uint32 length + text
+//   uint64 count, then that many AggregateEntry (month x category totals, snapshot category ids)
+// The header records how many bytes of transactions.txt the rows came from
+// and a checksum of those bytes, so a later start can tell whether the text
+// file was only appended to since.
+
+#pragma pack(push, 1)
+struct SnapshotHeader {
+    char magic[8];            // "PFTSNAPS"
+    uint32_t version;         // LedgerSnapshot::VERSION
+    uint32_t byteOrder;       // 0x01020304 as written by the host
+    uint64_t ledgerBytes;     // prefix of the text ledger covered, always ends after a newline
+    uint64_t ledgerLines;     // lines in that prefix
+    uint64_t ledgerChecksum;  // LedgerSnapshot::checksum of that prefix
+    uint64_t rowCount;
+    uint32_t categoryCount;
+    uint32_t reserved;
+    uint64_t errorCount;
+    uint64_t removedRows;     // TransactionStore::removedRows()
+    uint64_t editRecords;     // TransactionStore::editRecords()
+};
+#pragma pack(pop)
+
+// Saves and restores the parsed ledger so a start only has to parse what was appended since.
+class LedgerSnapshot {
+public:
+    static const uint32_t VERSION = 3;
+
+    // Writes the snapshot atomically. ledgerData/ledgerBytes is the text the store was built from.
+    static bool save(const std::string& path, const char* ledgerData, size_t ledgerBytes,
+                     const TransactionStore& store, const DateIndex& dateIndex,
+                     const AggregateTable& aggregates, std::string& error);
+
+    // Restores store, dateIndex and aggregates if the snapshot still matches the start of the ledger.
+    // On success coveredBytes/coveredLines say where parsing the tail has to begin.
+    // Returns false with a reason if there is no usable snapshot (missing, truncated or edited ledger).
+    static bool load(const std::string& path, const char* ledgerData, size_t ledgerBytes,
+                     TransactionStore& store, DateIndex& dateIndex, AggregateTable& aggregates,
+                     size_t& coveredBytes, size_t& coveredLines, std::string& reason);
+
+    // Fast 64-bit checksum (four independent multiply-rotate lanes, 32 bytes per step).
+    static uint64_t checksum(const char* data, size_t size);
+};
+
+#endif
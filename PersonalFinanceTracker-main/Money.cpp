@@ -0,0 +1,142 @@
+#include "Money.h"
+#include <charconv>   // std::from_chars
+#include <cmath>
+#include <ostream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MONEY_SSE2 1
+#endif
+
+Money Money::fromDollars(double amount) {
+    return Money(static_cast<int64_t>(std::llround(amount * 100.0)));
+}
+
+// Parses a decimal amount exactly, without going through double.
+bool Money::parse(std::string_view text, Money& result) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    bool negative = false;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // Whole dollars
+    uint64_t dollars = 0;
+    const char* digits = p;
+    if (p < end && *p != '.') {
+        auto parsed = std::from_chars(p, end, dollars);
+        if (parsed.ec != std::errc() || dollars > static_cast<uint64_t>(INT64_MAX / 100 - 1)) return false;
+        p = parsed.ptr;
+    }
+
+    // Cents, rounding half away from zero on the third decimal
+    int64_t cents = 0;
+    if (p < end && *p == '.') {
+        ++p;
+        int places = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (places < 2) {
+                cents = cents * 10 + (*p - '0');
+            } else if (places == 2 && *p >= '5') {
+                cents += 1;
+            }
+            ++places;
+            ++p;
+        }
+        if (places == 1) cents *= 10;
+        if (places == 0 && p - 1 == digits) return false; // just "."
+    }
+
+    if (p != end || p == digits) return false;
+
+    int64_t total = static_cast<int64_t>(dollars) * 100 + cents;
+    result = Money(negative ? -total : total);
+    return true;
+}
+
+// Two decimal places, no thousands separators.
+std::string Money::toString() const {
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    std::string text = std::to_string(magnitude / 100);
+    unsigned fraction = static_cast<unsigned>(magnitude % 100);
+
+    text += '.';
+    text += static_cast<char>('0' + fraction / 10);
+    text += static_cast<char>('0' + fraction % 10);
+    if (value < 0) text.insert(0, "-");
+    return text;
+}
+
+std::ostream& operator<<(std::ostream& out, Money amount) {
+    return out << amount.toString();
+}
+
+// Adds in unsigned arithmetic: wrapping is well defined and associative, which is
+// what makes any split of the work give the same bits.
+int64_t sumCents(const int64_t* cents, size_t count) {
+    size_t i = 0;
+    uint64_t total = 0;
+
+#ifdef MONEY_SSE2
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        acc0 = _mm_add_epi64(acc0, _mm_loadu_si128(reinterpret_cast<const __m128i*>(cents + i)));
+        acc1 = _mm_add_epi64(acc1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(cents + i + 2)));
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(acc0, acc1));
+    total = lanes[0] + lanes[1];
+#endif
+
+    for (; i < count; ++i) total += static_cast<uint64_t>(cents[i]);
+    return static_cast<int64_t>(total);
+}
+
+// Income is summed through a mask built from the type byte (0 or 1), expense is the remainder.
+void sumCentsByType(const int64_t* cents, const uint8_t* types, size_t count, int64_t& income, int64_t& expense) {
+    size_t i = 0;
+    uint64_t all = 0;
+    uint64_t in = 0;
+
+#ifdef MONEY_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i accAll = zero;
+    __m128i accIn = zero;
+    for (; i + 8 <= count; i += 8) {
+        // Widen eight type bytes to eight 64-bit masks of all-ones (income) or zero.
+        __m128i t8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(types + i));
+        __m128i t16 = _mm_unpacklo_epi8(t8, zero);
+        __m128i t32lo = _mm_unpacklo_epi16(t16, zero);
+        __m128i t32hi = _mm_unpackhi_epi16(t16, zero);
+        __m128i masks[4] = {
+            _mm_sub_epi64(zero, _mm_unpacklo_epi32(t32lo, zero)),
+            _mm_sub_epi64(zero, _mm_unpackhi_epi32(t32lo, zero)),
+            _mm_sub_epi64(zero, _mm_unpacklo_epi32(t32hi, zero)),
+            _mm_sub_epi64(zero, _mm_unpackhi_epi32(t32hi, zero)),
+        };
+        for (int k = 0; k < 4; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cents + i + 2 * k));
+            accAll = _mm_add_epi64(accAll, v);
+            accIn = _mm_add_epi64(accIn, _mm_and_si128(v, masks[k]));
+        }
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), accAll);
+    all = lanes[0] + lanes[1];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), accIn);
+    in = lanes[0] + lanes[1];
+#endif
+
+    for (; i < count; ++i) {
+        uint64_t v = static_cast<uint64_t>(cents[i]);
+        all += v;
+        in += v & (0 - static_cast<uint64_t>(types[i] & 1));
+    }
+
+    income = static_cast<int64_t>(in);
+    expense = static_cast<int64_t>(all - in);
+}
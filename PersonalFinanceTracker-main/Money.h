@@ -0,0 +1,48 @@
+#ifndef MONEY_H
+#define MONEY_H
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+// Fixed-point amount in integer cents. All arithmetic is exact, so totals do not
+// depend on the order rows are added in.
+class Money {
+public:
+    constexpr Money() : value(0) {}
+    static constexpr Money fromCents(int64_t cents) { return Money(cents); }
+    static constexpr double MAX_DOLLARS = 1e12;              // largest typed-in amount; keeps cents and totals far from overflow
+    static Money fromDollars(double amount);                 // rounds to the nearest cent; amount within +-MAX_DOLLARS
+    static bool parse(std::string_view text, Money& result); // "12", "12.5", "-3.07"; extra decimals are rounded
+
+    constexpr int64_t cents() const { return value; }
+    std::string toString() const;                            // "1234.50", "-0.07"
+
+    Money& operator+=(Money other) { value += other.value; return *this; }
+    Money& operator-=(Money other) { value -= other.value; return *this; }
+    friend Money operator+(Money a, Money b) { return Money(a.value + b.value); }
+    friend Money operator-(Money a, Money b) { return Money(a.value - b.value); }
+    friend bool operator==(Money a, Money b) { return a.value == b.value; }
+    friend bool operator!=(Money a, Money b) { return a.value != b.value; }
+    friend bool operator<(Money a, Money b) { return a.value < b.value; }
+    friend bool operator>(Money a, Money b) { return a.value > b.value; }
+    friend bool operator<=(Money a, Money b) { return a.value <= b.value; }
+    friend bool operator>=(Money a, Money b) { return a.value >= b.value; }
+
+private:
+    constexpr explicit Money(int64_t cents) : value(cents) {}
+    int64_t value;
+};
+
+std::ostream& operator<<(std::ostream& out, Money amount);
+
+// Summation kernels over contiguous cent columns. They add in wrapping 64-bit
+// integer arithmetic, so the result is bit-identical however the array is split
+// into chunks, reordered or spread across threads.
+int64_t sumCents(const int64_t* cents, size_t count);
+
+// Sums cents where types[i] is 1 (income) and 0 (expense) in one pass.
+void sumCentsByType(const int64_t* cents, const uint8_t* types, size_t count, int64_t& income, int64_t& expense);
+
+#endif
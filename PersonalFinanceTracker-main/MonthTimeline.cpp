@@ -0,0 +1,136 @@
+#include "MonthTimeline.h"
+#include "PackedDate.h"
+
+void MonthTimeline::clear() {
+    first = 0;
+    income.assign(1, 0);
+    expense.assign(1, 0);
+    categoryIncome.clear();
+    categoryExpense.clear();
+}
+
+// Buckets every live row by month, then turns the buckets into running sums.
+void MonthTimeline::rebuild(const TransactionStore& store) {
+    clear();
+    const std::vector<int32_t>& dates = store.dates();
+    const std::vector<uint8_t>& live = store.live();
+    if (store.liveRows() == 0) return;
+
+    int32_t low = INT32_MAX, high = INT32_MIN;
+    for (size_t i = 0; i < dates.size(); ++i) {
+        if (!live[i]) continue;
+        int32_t month = packedMonth(dates[i]);
+        if (month < low) low = month;
+        if (month > high) high = month;
+    }
+
+    first = low;
+    size_t months = static_cast<size_t>(high - low) + 1;
+    income.assign(months + 1, 0);
+    expense.assign(months + 1, 0);
+
+    const std::vector<uint8_t>& types = store.types();
+    const std::vector<uint16_t>& categories = store.categories();
+    const std::vector<int64_t>& cents = store.cents();
+    for (size_t i = 0; i < dates.size(); ++i) {
+        if (!live[i]) continue;
+        size_t index = static_cast<size_t>(packedMonth(dates[i]) - first) + 1;
+        uint16_t category = categories[i];
+        if (category >= categoryIncome.size()) {
+            categoryIncome.resize(category + 1u, std::vector<int64_t>(months + 1, 0));
+            categoryExpense.resize(category + 1u, std::vector<int64_t>(months + 1, 0));
+        }
+        bool isIncome = types[i] == static_cast<uint8_t>(TransactionType::Income);
+        (isIncome ? income : expense)[index] += cents[i];
+        (isIncome ? categoryIncome : categoryExpense)[category][index] += cents[i];
+    }
+
+    auto accumulate = [](std::vector<int64_t>& values) {
+        for (size_t i = 1; i < values.size(); ++i) values[i] += values[i - 1];
+    };
+    accumulate(income);
+    accumulate(expense);
+    for (size_t c = 0; c < categoryIncome.size(); ++c) {
+        accumulate(categoryIncome[c]);
+        accumulate(categoryExpense[c]);
+    }
+}
+
+// Adding months at the front inserts zeros (nothing happened before), adding them
+// at the back repeats the final running total.
+void MonthTimeline::cover(int32_t month) {
+    if (empty()) {
+        first = month;
+        income.assign(2, 0);
+        expense.assign(2, 0);
+        for (auto& values : categoryIncome) values.assign(2, 0);
+        for (auto& values : categoryExpense) values.assign(2, 0);
+        return;
+    }
+
+    auto grow = [](std::vector<int64_t>& values, size_t front, size_t back) {
+        if (front > 0) values.insert(values.begin(), front, 0);
+        if (back > 0) values.insert(values.end(), back, values.back());
+    };
+
+    size_t front = month < first ? static_cast<size_t>(first - month) : 0;
+    size_t back = month > lastMonth() ? static_cast<size_t>(month - lastMonth()) : 0;
+    if (front == 0 && back == 0) return;
+
+    grow(income, front, back);
+    grow(expense, front, back);
+    for (auto& values : categoryIncome) grow(values, front, back);
+    for (auto& values : categoryExpense) grow(values, front, back);
+    first -= static_cast<int32_t>(front);
+}
+
+void MonthTimeline::add(const Transaction& transaction) {
+    shift(transaction, transaction.getAmount().cents());
+}
+
+void MonthTimeline::remove(const Transaction& transaction) {
+    shift(transaction, -transaction.getAmount().cents());
+}
+
+void MonthTimeline::shift(const Transaction& transaction, int64_t cents) {
+    int32_t month = packedMonth(transaction.getDate());
+    cover(month);
+
+    uint16_t category = transaction.getCategoryId();
+    if (category >= categoryIncome.size()) {
+        categoryIncome.resize(category + 1u, std::vector<int64_t>(income.size(), 0));
+        categoryExpense.resize(category + 1u, std::vector<int64_t>(income.size(), 0));
+    }
+
+    bool isIncome = transaction.getType() == TransactionType::Income;
+    std::vector<int64_t>& total = isIncome ? income : expense;
+    std::vector<int64_t>& perCategory = (isIncome ? categoryIncome : categoryExpense)[category];
+    for (size_t i = static_cast<size_t>(month - first) + 1; i < total.size(); ++i) {
+        total[i] += cents;
+        perCategory[i] += cents;
+    }
+}
+
+size_t MonthTimeline::slot(int32_t month) const {
+    if (month < first) return 0;
+    size_t index = static_cast<size_t>(month - first) + 1;
+    return index < income.size() ? index : income.size() - 1;
+}
+
+Totals MonthTimeline::range(int32_t from, int32_t to) const {
+    Totals totals;
+    if (empty() || to < from) return totals;
+    size_t begin = slot(from - 1), end = slot(to);
+    totals.income = Money::fromCents(income[end] - income[begin]);
+    totals.expense = Money::fromCents(expense[end] - expense[begin]);
+    return totals;
+}
+
+Totals MonthTimeline::categoryRange(uint16_t category, int32_t from, int32_t to) const {
+    Totals totals;
+    if (empty() || to < from || category >= categoryIncome.size()) return totals;
+    size_t begin = slot(from - 1), end = slot(to);
+    totals.income = Money::fromCents(categoryIncome[category][end] - categoryIncome[category][begin]);
+    totals.expense = Money::fromCents(categoryExpense[category][end] - categoryExpense[category][begin]);
+    return totals;
+}
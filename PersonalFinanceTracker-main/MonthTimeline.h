@@ -0,0 +1,39 @@
+#ifndef MONTHTIMELINE_H
+#define MONTHTIMELINE_H
+#include "AggregateTable.h"
+#include "TransactionStore.h"
+#include <cstdint>
+#include <vector>
+
+// Running (prefix) sums of income and expense per month, for the whole
+// ledger and per category. Entry i holds the totals of every month before
+// first + i, so the totals of any month range are two subtractions,
+// however long the range is. Months are numbered like packedMonth()
+// (year * 16 + month), so each year has a few unused slots that stay zero.
+class MonthTimeline {
+public:
+    void clear();
+    void rebuild(const TransactionStore& store);    // one pass over the rows, then one over the months
+    void add(const Transaction& transaction);       // cheap for the latest month, walks later months otherwise
+    void remove(const Transaction& transaction);    // undo add() for a deleted or replaced row
+
+    bool empty() const { return income.size() <= 1; }
+    int32_t firstMonth() const { return first; }    // packedMonth() values, valid when not empty
+    int32_t lastMonth() const { return first + static_cast<int32_t>(income.size()) - 2; }
+
+    // Totals over from..to inclusive (packed months). Months outside the ledger count as zero.
+    Totals range(int32_t from, int32_t to) const;
+    Totals categoryRange(uint16_t category, int32_t from, int32_t to) const;
+    size_t categoryCount() const { return categoryIncome.size(); } // category ids seen so far are < this
+
+private:
+    void cover(int32_t month);                      // grow the arrays so month has a slot
+    void shift(const Transaction& transaction, int64_t cents); // add cents from the row's month on
+    size_t slot(int32_t month) const;               // prefix index just past month, clamped to the arrays
+
+    int32_t first = 0;
+    std::vector<int64_t> income{0}, expense{0};     // cents, size = months + 1
+    std::vector<std::vector<int64_t>> categoryIncome, categoryExpense; // [category id][prefix index]
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "PackedDate.h"
+#include <cctype>
+
+// Accepts exactly ten characters YYYY-MM-DD with month 1-12 and day 1-31.
+bool packDate(std::string_view text, int32_t& packed) {
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-') return false;
+    for (int i : {0, 1, 2, 3, 5, 6, 8, 9})
+        if (!std::isdigit(static_cast<unsigned char>(text[i]))) return false;
+
+    int year = (text[0] - '0') * 1000 + (text[1] - '0') * 100 + (text[2] - '0') * 10 + (text[3] - '0');
+    int month = (text[5] - '0') * 10 + (text[6] - '0');
+    int day = (text[8] - '0') * 10 + (text[9] - '0');
+    if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+
+    packed = year * 512 + month * 32 + day;
+    return true;
+}
+
+// Accepts exactly seven characters YYYY-MM with month 1-12.
+bool packMonth(std::string_view text, int32_t& month) {
+    if (text.size() != 7 || text[4] != '-') return false;
+    for (int i : {0, 1, 2, 3, 5, 6})
+        if (!std::isdigit(static_cast<unsigned char>(text[i]))) return false;
+
+    int year = (text[0] - '0') * 1000 + (text[1] - '0') * 100 + (text[2] - '0') * 10 + (text[3] - '0');
+    int monthNum = (text[5] - '0') * 10 + (text[6] - '0');
+    if (monthNum < 1 || monthNum > 12) return false;
+
+    month = year * 16 + monthNum;
+    return true;
+}
+
+// A month is a date without its day.
+std::string unpackMonth(int32_t month) {
+    return unpackDate(month * 32).substr(0, 7);
+}
+
+// Writes the digits back out without going through a stream.
+std::string unpackDate(int32_t packed) {
+    int year = packed / 512;
+    int month = (packed / 32) % 16;
+    int day = packed % 32;
+
+    std::string text = "0000-00-00";
+    text[0] = static_cast<char>('0' + year / 1000 % 10);
+    text[1] = static_cast<char>('0' + year / 100 % 10);
+    text[2] = static_cast<char>('0' + year / 10 % 10);
+    text[3] = static_cast<char>('0' + year % 10);
+    text[5] = static_cast<char>('0' + month / 10);
+    text[6] = static_cast<char>('0' + month % 10);
+    text[8] = static_cast<char>('0' + day / 10);
+    text[9] = static_cast<char>('0' + day % 10);
+    return text;
+}
@@ -0,0 +1,26 @@
+#ifndef PACKEDDATE_H
+#define PACKEDDATE_H
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Dates are stored as one integer: year * 512 + month * 32 + day.
+// Ordering the integers orders the dates, the month is simply packed >> 5,
+// and every string isValidDate() accepts round-trips exactly.
+
+// "YYYY-MM-DD" -> packed date. Returns false if the text is not in that form.
+bool packDate(std::string_view text, int32_t& packed);
+
+// "YYYY-MM" -> the same value packedMonth() gives for any day in that month.
+bool packMonth(std::string_view text, int32_t& month);
+
+// Packed date -> "YYYY-MM-DD".
+std::string unpackDate(int32_t packed);
+
+// Packed month -> "YYYY-MM".
+std::string unpackMonth(int32_t month);
+
+// Month part of a packed date (year * 16 + month), comparable across years.
+inline int32_t packedMonth(int32_t packed) { return packed >> 5; }
+
+#endif
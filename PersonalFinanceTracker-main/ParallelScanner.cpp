@@ -0,0 +1,178 @@
+#include "ParallelScanner.h"
+#include "CategoryPool.h"
+#include "CategoryRegistry.h"
+#include "LedgerParser.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+// A #delete or #replace line. Its target may be in an earlier chunk, so it is
+// checked and applied during the merge, once the rows before it are in place.
+struct ChunkEdit {
+    LedgerRowKind kind;
+    size_t target;
+    Transaction replacement;   // Replace only, with a chunk-local category id
+    size_t rowsBefore;         // rows of the chunk ahead of the line
+    size_t lineNumber;         // within the chunk
+    std::string text;
+};
+
+// Everything one worker produces. Category ids are local to the chunk until merged.
+struct ChunkResult {
+    size_t begin = 0, end = 0;
+    TransactionStore rows;
+    AggregateTable totals;
+    std::vector<std::string_view> categoryNames;   // local id -> name (predefined ones first, the rest point into the mapping)
+    std::vector<ParseError> errors;
+    std::vector<ChunkEdit> edits;
+    size_t lines = 0;
+};
+
+ParallelScanner::ParallelScanner(unsigned threads)
+    : threads(threads == 0 ? ThreadPool::defaultThreads() : threads) {}
+
+std::vector<std::pair<size_t, size_t>> ParallelScanner::splitChunks(const char* data, size_t size, size_t chunks) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    if (chunks == 0) chunks = 1;
+
+    size_t begin = 0;
+    for (size_t i = 1; i <= chunks && begin < size; ++i) {
+        size_t end = (i == chunks) ? size : size * i / chunks;
+        if (end < begin) end = begin;
+        // Move the cut forward to just past the next newline.
+        const char* nl = LedgerParser::findByte(data + end, data + size, '\n');
+        end = (nl == data + size) ? size : static_cast<size_t>(nl - data) + 1;
+        if (i == chunks) end = size;
+        ranges.emplace_back(begin, end);
+        begin = end;
+    }
+    return ranges;
+}
+
+// Parses one chunk into local columns and totals. Predefined categories use
+// their registry ids locally too; only other names go through a hash map.
+static void scanChunk(const char* data, ChunkResult& chunk) {
+    std::unordered_map<std::string_view, uint16_t> localIds;
+    for (const CategoryInfo& category : CATEGORIES) chunk.categoryNames.push_back(category.name);
+
+    LedgerParser::parseBuffer(data + chunk.begin, chunk.end - chunk.begin, true, chunk.lines,
+        [&](const LedgerRow& row) {
+            if (row.kind == LedgerRowKind::Gap || row.kind == LedgerRowKind::Unreadable) {
+                chunk.rows.appendGap(row.kind == LedgerRowKind::Gap ? row.target : 1);
+                return;
+            }
+            if (row.kind == LedgerRowKind::Delete) {
+                chunk.edits.push_back({row.kind, row.target, Transaction(TransactionType::Expense, Money(), 0, 0),
+                                       chunk.rows.size(), row.lineNumber, std::string(row.text)});
+                return;
+            }
+            uint16_t id = 0;
+            if (!CategoryRegistry::find(row.category, id)) {
+                auto it = localIds.find(row.category);
+                if (it == localIds.end()) {
+                    it = localIds.emplace(row.category, static_cast<uint16_t>(chunk.categoryNames.size())).first;
+                    chunk.categoryNames.push_back(row.category);
+                }
+                id = it->second;
+            }
+            Transaction t(row.transactionType, row.amount, id, row.packedDate);
+            if (row.kind == LedgerRowKind::Replace) {
+                chunk.edits.push_back({row.kind, row.target, t, chunk.rows.size(), row.lineNumber, std::string(row.text)});
+                return;
+            }
+            chunk.rows.append(t);
+            chunk.totals.add(t);
+        }, chunk.errors);
+}
+
+bool ParallelScanner::load(const std::string& path, TransactionStore& store, AggregateTable& aggregates) {
+    aggregates.clear();
+
+    MappedFile file;
+    {
+        ScopedTimer timer("load.open");
+        if (!file.open(path)) {
+            store.clear();
+            return false;
+        }
+    }
+
+    size_t chunks = file.size() / MIN_CHUNK_BYTES;
+    if (chunks > threads) chunks = threads;
+
+    // Sequential path: small file or a single thread requested.
+    if (chunks <= 1) {
+        file.close();
+        ScopedTimer timer("load.parse");
+        if (!store.loadFromFile(path)) return false;
+        for (size_t i = 0; i < store.size(); ++i) {
+            if (store.isLive(i)) aggregates.add(store.at(i));
+        }
+        return true;
+    }
+
+    std::vector<std::pair<size_t, size_t>> ranges = splitChunks(file.data(), file.size(), chunks);
+    std::vector<ChunkResult> results(ranges.size());
+    Profiler::count(Profiler::Counter::BytesRead, file.size());
+    {
+        ScopedTimer timer("load.parse");
+        ThreadPool pool(static_cast<unsigned>(ranges.size()));
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            results[i].begin = ranges[i].first;
+            results[i].end = ranges[i].second;
+            ChunkResult* chunk = &results[i];
+            const char* data = file.data();
+            pool.submit([data, chunk] { scanChunk(data, *chunk); });
+        }
+        pool.wait();
+    }
+
+    // Merge in file order so rows, line numbers and totals match the sequential load.
+    ScopedTimer timer("load.merge");
+    store.clear();
+    std::vector<ParseError> errors;
+    size_t lineBase = 0;
+    for (ChunkResult& chunk : results) {
+        std::vector<uint16_t> remap;
+        remap.reserve(chunk.categoryNames.size());
+        for (std::string_view name : chunk.categoryNames) {
+            remap.push_back(CategoryPool::intern(name));
+        }
+
+        size_t base = store.size();
+        store.appendChunk(chunk.rows, remap);
+        aggregates.merge(chunk.totals, remap);
+
+        for (ChunkEdit& edit : chunk.edits) {
+            bool ok = edit.target < base + edit.rowsBefore && store.isLive(edit.target);
+            if (ok) {
+                aggregates.remove(store.at(edit.target));
+                if (edit.kind == LedgerRowKind::Delete) {
+                    store.remove(edit.target);
+                } else {
+                    Transaction& t = edit.replacement;
+                    t = Transaction(t.getType(), t.getAmount(), remap[t.getCategoryId()], t.getDate());
+                    store.replace(edit.target, t);
+                    aggregates.add(t);
+                }
+            } else {
+                errors.push_back({edit.lineNumber + lineBase, "no live transaction with id " + std::to_string(edit.target),
+                                  std::move(edit.text)});
+            }
+        }
+        for (ParseError& e : chunk.errors) {
+            e.lineNumber += lineBase;
+            errors.push_back(std::move(e));
+        }
+        lineBase += chunk.lines;
+    }
+
+    // Edit errors were collected apart from the parse errors of their chunk.
+    std::stable_sort(errors.begin(), errors.end(),
+                     [](const ParseError& a, const ParseError& b) { return a.lineNumber < b.lineNumber; });
+    store.finishLoad(std::move(errors));
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef PARALLELSCANNER_H
+#define PARALLELSCANNER_H
+#include "AggregateTable.h"
+#include "TransactionStore.h"
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Loads a text ledger on several threads. The memory-mapped file is cut into
+// newline-aligned chunks; each worker parses its chunk into its own columns
+// and aggregate table, and the partial results are merged in chunk order.
+// Because rows keep their order and totals are integer cents, the result is
+// identical to a single-threaded load.
+class ParallelScanner {
+public:
+    explicit ParallelScanner(unsigned threads); // 0 means one per hardware thread
+
+    // Fills store and aggregates from path. Returns false if the file could not be opened.
+    bool load(const std::string& path, TransactionStore& store, AggregateTable& aggregates);
+
+    // Splits [0, size) into at most `chunks` ranges that each end just after a newline.
+    static std::vector<std::pair<size_t, size_t>> splitChunks(const char* data, size_t size, size_t chunks);
+
+    static const size_t MIN_CHUNK_BYTES = 1 << 20; // smaller files are read on one thread
+
+private:
+    unsigned threads;
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <new>
+
+// Counts heap allocations for the profiler. Every replaceable form of operator
+// new and delete is defined here on top of malloc/free: replacing only some of
+// them would hand memory from the library's heap to these deletes and back.
+static void* allocate(std::size_t size) {
+    if (Profiler::enabled()) Profiler::countAllocation();
+    if (size == 0) size = 1;
+    while (true) {
+        if (void* p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+static void* allocateNoThrow(std::size_t size) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+// Over-aligned types: over-allocate and keep malloc's pointer just before the
+// aligned block (aligned_alloc is missing on MinGW).
+static void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+    std::size_t align = std::max(static_cast<std::size_t>(alignment), alignof(void*));
+    if (size > SIZE_MAX - align - sizeof(void*)) throw std::bad_alloc();
+    void* raw = allocate(size + align + sizeof(void*));
+    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+    std::uintptr_t aligned = (start + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    return reinterpret_cast<void*>(aligned);
+}
+
+static void* allocateAlignedNoThrow(std::size_t size, std::align_val_t alignment) noexcept {
+    try {
+        return allocateAligned(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+static void releaseAligned(void* p) noexcept {
+    if (p) std::free(static_cast<void**>(p)[-1]);
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocateNoThrow(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocateNoThrow(size); }
+void* operator new(std::size_t size, std::align_val_t al) { return allocateAligned(size, al); }
+void* operator new[](std::size_t size, std::align_val_t al) { return allocateAligned(size, al); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocateAlignedNoThrow(size, al);
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocateAlignedNoThrow(size, al);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(p); }
+
+std::deque<Profiler::Operation>& Profiler::operations() {
+    static std::deque<Operation> list;
+    return list;
+}
+
+Profiler::Operation* Profiler::find(const char* name) {
+    for (Operation& op : operations()) {
+        if (op.name == name || std::strcmp(op.name, name) == 0) return &op;
+    }
+    operations().push_back({name, {}, {}});
+    return &operations().back();
+}
+
+void Profiler::count(Counter counter, uint64_t amount) {
+    if (!on || !current) return;
+    uint64_t OperationCounters::*field = &OperationCounters::bytesRead;
+    switch (counter) {
+    case Counter::BytesRead:    field = &OperationCounters::bytesRead; break;
+    case Counter::BytesWritten: field = &OperationCounters::bytesWritten; break;
+    case Counter::RowsParsed:   field = &OperationCounters::rowsParsed; break;
+    case Counter::RowsMatched:  field = &OperationCounters::rowsMatched; break;
+    case Counter::ParseErrors:  field = &OperationCounters::parseErrors; break;
+    }
+    current->total.*field += amount;
+    current->recent.*field += amount;
+}
+
+void Profiler::printRecent(std::ostream& out) {
+    if (!on) return;
+
+    bool header = false;
+    for (Operation& op : operations()) {
+        const OperationCounters& c = op.recent;
+        if (c.calls == 0) continue;
+        if (!header) {
+            out << "\n" << std::left << std::setw(26) << "operation" << std::right
+                << std::setw(6) << "calls" << std::setw(11) << "ms" << std::setw(12) << "read"
+                << std::setw(12) << "written" << std::setw(10) << "parsed" << std::setw(10) << "matched"
+                << std::setw(8) << "errors" << std::setw(9) << "allocs" << "\n";
+            header = true;
+        }
+        out << std::left << std::setw(26) << op.name << std::right
+            << std::setw(6) << c.calls
+            << std::setw(11) << std::fixed << std::setprecision(3) << c.nanoseconds / 1e6
+            << std::setw(12) << c.bytesRead << std::setw(12) << c.bytesWritten
+            << std::setw(10) << c.rowsParsed << std::setw(10) << c.rowsMatched
+            << std::setw(8) << c.parseErrors << std::setw(9) << c.allocations << "\n";
+        op.recent = OperationCounters();
+    }
+    out << std::defaultfloat;
+}
+
+void Profiler::writeJson(std::ostream& out) {
+    out << "{\"operations\":[";
+    bool first = true;
+    for (const Operation& op : operations()) {
+        const OperationCounters& c = op.total;
+        out << (first ? "" : ",") << "\n  {\"name\":\"" << op.name << "\""
+            << ",\"calls\":" << c.calls
+            << ",\"ms\":" << std::fixed << std::setprecision(3) << c.nanoseconds / 1e6 << std::defaultfloat
+            << ",\"bytes_read\":" << c.bytesRead
+            << ",\"bytes_written\":" << c.bytesWritten
+            << ",\"rows_parsed\":" << c.rowsParsed
+            << ",\"rows_matched\":" << c.rowsMatched
+            << ",\"parse_errors\":" << c.parseErrors
+            << ",\"allocations\":" << c.allocations << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+ScopedTimer::ScopedTimer(const char* name) {
+    if (!Profiler::on) return;
+    operation = Profiler::find(name);
+    parent = Profiler::current;
+    Profiler::current = operation;
+    allocationsAtStart = Profiler::allocations.load(std::memory_order_relaxed);
+    start = std::chrono::steady_clock::now();
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (!operation) return;
+    uint64_t nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    uint64_t allocated = Profiler::allocations.load(std::memory_order_relaxed) - allocationsAtStart;
+
+    for (OperationCounters* c : {&operation->total, &operation->recent}) {
+        ++c->calls;
+        c->nanoseconds += nanoseconds;
+        c->allocations += allocated;
+    }
+    Profiler::current = parent;
+}
@@ -0,0 +1,70 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+
+// What was measured for one named operation.
+struct OperationCounters {
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t rowsParsed = 0;
+    uint64_t rowsMatched = 0;
+    uint64_t parseErrors = 0;
+    uint64_t allocations = 0;   // operator new calls while the operation ran (all threads)
+};
+
+// Opt-in instrumentation for --stats. Operations are timed with ScopedTimer;
+// counters are added to the innermost timer running on the calling thread, so
+// calls from worker threads are ignored and the owner adds their totals after
+// merging. While disabled every hook is a single branch on a bool.
+class Profiler {
+public:
+    enum class Counter { BytesRead, BytesWritten, RowsParsed, RowsMatched, ParseErrors };
+
+    static void enable() { on = true; }
+    static bool enabled() { return on; }
+
+    static void count(Counter counter, uint64_t amount);
+    static void countAllocation() { allocations.fetch_add(1, std::memory_order_relaxed); }
+
+    static void printRecent(std::ostream& out); // operations since the last call as a table, then starts over
+    static void writeJson(std::ostream& out);   // totals for the whole run
+
+private:
+    friend class ScopedTimer;
+
+    struct Operation {
+        const char* name;
+        OperationCounters total;
+        OperationCounters recent;
+    };
+
+    static Operation* find(const char* name);   // creates the entry on first use
+
+    static inline bool on = false;
+    static inline std::atomic<uint64_t> allocations{0};
+    static inline thread_local Operation* current = nullptr;
+    static std::deque<Operation>& operations();
+};
+
+// Times the enclosing scope under name (a string literal). Main thread only; does nothing unless the profiler is enabled.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name);
+    ~ScopedTimer();
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Profiler::Operation* operation = nullptr;
+    Profiler::Operation* parent = nullptr;
+    std::chrono::steady_clock::time_point start;
+    uint64_t allocationsAtStart = 0;
+};
+
+#endif
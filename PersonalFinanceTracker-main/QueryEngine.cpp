@@ -0,0 +1,237 @@
+#include "QueryEngine.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+static const size_t BLOCK_SIZE = 1024;
+
+Predicate Predicate::all() {
+    return Predicate();
+}
+
+Predicate Predicate::dateRange(int32_t from, int32_t to) {
+    Predicate p;
+    p.kind = Kind::DateRange;
+    p.fromDate = from;
+    p.toDate = to;
+    return p;
+}
+
+Predicate Predicate::type(TransactionType type) {
+    Predicate p;
+    p.kind = Kind::Type;
+    p.typeValue = static_cast<uint8_t>(type);
+    return p;
+}
+
+Predicate Predicate::categories(std::vector<uint16_t> ids) {
+    Predicate p;
+    p.kind = Kind::Categories;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    if (!ids.empty()) p.categoryLookup.assign(ids.back() + 1u, 0);
+    for (uint16_t id : ids) p.categoryLookup[id] = 1;
+    p.categoryIds = std::move(ids);
+    return p;
+}
+
+Predicate Predicate::amountRange(Money min, Money max) {
+    Predicate p;
+    p.kind = Kind::AmountRange;
+    p.minCents = min.cents();
+    p.maxCents = max.cents();
+    return p;
+}
+
+Predicate Predicate::amountAtLeast(Money min) {
+    return amountRange(min, Money::fromCents(std::numeric_limits<int64_t>::max()));
+}
+
+Predicate Predicate::amountAtMost(Money max) {
+    return amountRange(Money::fromCents(std::numeric_limits<int64_t>::min()), max);
+}
+
+Predicate Predicate::allOf(std::vector<Predicate> children) {
+    Predicate p;
+    p.kind = Kind::And;
+    p.children = std::move(children);
+    return p;
+}
+
+Predicate Predicate::anyOf(std::vector<Predicate> children) {
+    Predicate p;
+    p.kind = Kind::Or;
+    p.children = std::move(children);
+    return p;
+}
+
+Predicate Predicate::negate(Predicate child) {
+    Predicate p;
+    p.kind = Kind::Not;
+    p.children.push_back(std::move(child));
+    return p;
+}
+
+QueryEngine::QueryEngine(const TransactionStore& store, const DateIndex& dates, const CategoryIndex& categories)
+    : store(store), dateIndex(dates), categoryIndex(categories) {}
+
+// Applies column test f to each row of the block. Contiguous blocks read the
+// column directly, which lets the compiler vectorize the loop.
+template <typename T, typename Test>
+static void applyColumn(const std::vector<T>& column, const uint32_t* ids, size_t start, size_t count,
+                        uint8_t* mask, Test f) {
+    if (ids) {
+        for (size_t i = 0; i < count; ++i) mask[i] = f(column[ids[i]]) ? 1 : 0;
+    } else {
+        const T* values = column.data() + start;
+        for (size_t i = 0; i < count; ++i) mask[i] = f(values[i]) ? 1 : 0;
+    }
+}
+
+// Fills mask[0..count) with 1 where the predicate holds, one column at a time.
+void QueryEngine::evaluate(const Predicate& p, const uint32_t* ids, size_t start, size_t count, uint8_t* mask) const {
+    switch (p.kind) {
+    case Predicate::Kind::All:
+        std::memset(mask, 1, count);
+        break;
+
+    case Predicate::Kind::DateRange: {
+        const int32_t from = p.fromDate, to = p.toDate;
+        applyColumn(store.dates(), ids, start, count, mask, [from, to](int32_t d) { return d >= from && d <= to; });
+        break;
+    }
+
+    case Predicate::Kind::Type: {
+        const uint8_t wanted = p.typeValue;
+        applyColumn(store.types(), ids, start, count, mask, [wanted](uint8_t t) { return t == wanted; });
+        break;
+    }
+
+    case Predicate::Kind::Categories: {
+        const uint8_t* lookup = p.categoryLookup.data();
+        const size_t size = p.categoryLookup.size();
+        applyColumn(store.categories(), ids, start, count, mask,
+                    [lookup, size](uint16_t c) { return c < size && lookup[c]; });
+        break;
+    }
+
+    case Predicate::Kind::AmountRange: {
+        const int64_t lo = p.minCents, hi = p.maxCents;
+        applyColumn(store.cents(), ids, start, count, mask, [lo, hi](int64_t c) { return c >= lo && c <= hi; });
+        break;
+    }
+
+    case Predicate::Kind::And:
+    case Predicate::Kind::Or: {
+        bool isAnd = p.kind == Predicate::Kind::And;
+        std::memset(mask, isAnd ? 1 : 0, count);
+        uint8_t part[BLOCK_SIZE];
+        for (const Predicate& child : p.children) {
+            evaluate(child, ids, start, count, part);
+            if (isAnd) {
+                for (size_t i = 0; i < count; ++i) mask[i] &= part[i];
+            } else {
+                for (size_t i = 0; i < count; ++i) mask[i] |= part[i];
+            }
+        }
+        break;
+    }
+
+    case Predicate::Kind::Not:
+        evaluate(p.children.front(), ids, start, count, mask);
+        for (size_t i = 0; i < count; ++i) mask[i] ^= 1;
+        break;
+    }
+}
+
+// If the predicate (or a term of a top-level And) is a category set or date range,
+// the indexes give a sorted candidate list much smaller than the whole store.
+bool QueryEngine::candidatesFromIndex(const Predicate& where, std::vector<uint32_t>& candidates) const {
+    std::vector<const Predicate*> terms;
+    if (where.kind == Predicate::Kind::And) {
+        for (const Predicate& child : where.children) terms.push_back(&child);
+    } else {
+        terms.push_back(&where);
+    }
+
+    for (const Predicate* term : terms) {
+        if (term->kind == Predicate::Kind::Categories) {
+            candidates = categoryIndex.rowsInAny(term->categoryIds);
+            return true;
+        }
+    }
+    for (const Predicate* term : terms) {
+        if (term->kind == Predicate::Kind::DateRange) {
+            DateIndex::Range range = dateIndex.between(term->fromDate, term->toDate);
+            candidates.assign(range.begin, range.end);
+            std::sort(candidates.begin(), candidates.end());
+            return true;
+        }
+    }
+    return false;
+}
+
+QueryResult QueryEngine::run(const Query& query) const {
+    QueryResult result;
+    std::vector<uint32_t> candidates;
+    bool indexed = candidatesFromIndex(query.where, candidates);
+    size_t total = indexed ? candidates.size() : store.size();
+
+    uint8_t mask[BLOCK_SIZE];
+    int64_t matchCents[BLOCK_SIZE];
+    uint8_t matchTypes[BLOCK_SIZE];
+    int64_t income = 0, expense = 0;
+
+    // Single pass over the rows, one block at a time.
+    for (size_t start = 0; start < total; start += BLOCK_SIZE) {
+        size_t count = std::min(BLOCK_SIZE, total - start);
+        const uint32_t* ids = indexed ? candidates.data() + start : nullptr;
+        evaluate(query.where, ids, start, count, mask);
+        if (!ids) {
+            // The indexes hold live rows only; a full scan has to drop the dead ones itself.
+            const uint8_t* live = store.live().data() + start;
+            for (size_t i = 0; i < count; ++i) mask[i] &= live[i];
+        }
+
+        size_t matched = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (!mask[i]) continue;
+            uint32_t row = ids ? ids[i] : static_cast<uint32_t>(start + i);
+            result.rows.push_back(row);
+            matchCents[matched] = store.cents()[row];
+            matchTypes[matched] = store.types()[row];
+            ++matched;
+        }
+
+        int64_t blockIncome = 0, blockExpense = 0;
+        sumCentsByType(matchCents, matchTypes, matched, blockIncome, blockExpense);
+        income += blockIncome;
+        expense += blockExpense;
+    }
+    result.income = Money::fromCents(income);
+    result.expense = Money::fromCents(expense);
+
+    // Rows come out in file order; stable sorts keep that order for ties.
+    const std::vector<int32_t>& dates = store.dates();
+    const std::vector<int64_t>& cents = store.cents();
+    switch (query.order) {
+    case SortOrder::File:
+        break;
+    case SortOrder::Date:
+        std::stable_sort(result.rows.begin(), result.rows.end(),
+                         [&dates](uint32_t a, uint32_t b) { return dates[a] < dates[b]; });
+        break;
+    case SortOrder::AmountAscending:
+        std::stable_sort(result.rows.begin(), result.rows.end(),
+                         [&cents](uint32_t a, uint32_t b) { return cents[a] < cents[b]; });
+        break;
+    case SortOrder::AmountDescending:
+        std::stable_sort(result.rows.begin(), result.rows.end(),
+                         [&cents](uint32_t a, uint32_t b) { return cents[a] > cents[b]; });
+        break;
+    }
+
+    if (query.limit > 0 && result.rows.size() > query.limit) result.rows.resize(query.limit);
+    return result;
+}
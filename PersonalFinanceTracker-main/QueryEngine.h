@@ -0,0 +1,74 @@
+#ifndef QUERYENGINE_H
+#define QUERYENGINE_H
+#include "CategoryIndex.h"
+#include "DateIndex.h"
+#include "Money.h"
+#include "TransactionStore.h"
+#include <cstdint>
+#include <vector>
+
+// A condition on a transaction: a leaf test on one column, or And/Or/Not of other predicates.
+class Predicate {
+public:
+    enum class Kind { All, DateRange, Type, Categories, AmountRange, And, Or, Not };
+
+    static Predicate all();                                           // matches every row
+    static Predicate dateRange(int32_t from, int32_t to);             // packed dates, inclusive
+    static Predicate type(TransactionType type);
+    static Predicate categories(std::vector<uint16_t> ids);           // any of these CategoryPool ids
+    static Predicate amountRange(Money min, Money max);               // inclusive
+    static Predicate amountAtLeast(Money min);
+    static Predicate amountAtMost(Money max);
+    static Predicate allOf(std::vector<Predicate> children);          // And
+    static Predicate anyOf(std::vector<Predicate> children);          // Or
+    static Predicate negate(Predicate child);                         // Not
+
+    Kind kind = Kind::All;
+    int32_t fromDate = 0, toDate = 0;
+    uint8_t typeValue = 0;
+    std::vector<uint16_t> categoryIds;
+    std::vector<uint8_t> categoryLookup;  // categoryLookup[id] is 1 for ids in categoryIds
+    int64_t minCents = 0, maxCents = 0;
+    std::vector<Predicate> children;
+};
+
+// Columns a query hands back, in display order.
+enum class Field { Date, Type, Category, Amount, Id }; // Id: the row's transaction id
+
+// Order of the returned rows. Ties always keep file order.
+enum class SortOrder { File, Date, AmountAscending, AmountDescending };
+
+struct Query {
+    Predicate where = Predicate::all();
+    SortOrder order = SortOrder::File;
+    size_t limit = 0;                                   // 0 means no limit
+    std::vector<Field> columns = {Field::Date, Field::Type, Field::Category, Field::Amount};
+};
+
+struct QueryResult {
+    std::vector<uint32_t> rows; // matching store rows, in the requested order
+    Money income;               // totals over every match (before the limit)
+    Money expense;
+};
+
+// Evaluates a Query over the in-memory columns in a single pass. Rows are
+// processed in blocks, and each predicate is applied to a whole column slice
+// at a time with tight loops the compiler can vectorize. When the predicate
+// pins a category set or date range, the matching index supplies the
+// candidate rows instead of a full scan.
+class QueryEngine {
+public:
+    QueryEngine(const TransactionStore& store, const DateIndex& dates, const CategoryIndex& categories);
+
+    QueryResult run(const Query& query) const;
+
+private:
+    bool candidatesFromIndex(const Predicate& where, std::vector<uint32_t>& candidates) const;
+    void evaluate(const Predicate& p, const uint32_t* ids, size_t start, size_t count, uint8_t* mask) const;
+
+    const TransactionStore& store;
+    const DateIndex& dateIndex;
+    const CategoryIndex& categoryIndex;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "ResultWriter.h"
+#include "CategoryPool.h"
+#include "PackedDate.h"
+#include "Profiler.h"
+#include <iostream>   // std::cin for the pager
+
+ResultWriter::ResultWriter(std::ostream& out, const OutputOptions& options, size_t bufferBytes)
+    : out(out), options(options), limit(bufferBytes) {
+    buffer.reserve(limit + 256);
+}
+
+ResultWriter::~ResultWriter() {
+    flush();
+}
+
+void ResultWriter::flush() {
+    if (buffer.empty()) return;
+    ScopedTimer timer("console output");
+    Profiler::count(Profiler::Counter::BytesWritten, buffer.size());
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    buffer.clear();
+}
+
+// Decides whether the next row is printed, asking for the next page when one is full.
+bool ResultWriter::admit() {
+    if (stopped) return false;
+    if (offered++ < options.offset) return false;
+    if (options.limit > 0 && printedRows >= options.limit) {
+        stopped = true;
+        return false;
+    }
+
+    if (options.format == OutputFormat::Table && options.pageSize > 0 &&
+        printedRows > 0 && printedRows % options.pageSize == 0) {
+        flush();
+        out << "-- Press Enter for the next page, or q to stop: ";
+        out.flush();
+        std::string answer;
+        if (!std::getline(std::cin, answer) || answer == "q" || answer == "Q") {
+            stopped = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ResultWriter::row(const TransactionStore& store, uint32_t row, const std::vector<Field>& columns) {
+    if (!admit()) return !stopped;
+    append(row, store.dates()[row], store.types()[row], store.categories()[row], store.cents()[row], columns);
+    return true;
+}
+
+bool ResultWriter::row(const Transaction& transaction) {
+    if (!admit()) return !stopped;
+    append(0, transaction.getDate(), static_cast<uint8_t>(transaction.getType()), transaction.getCategoryId(),
+           transaction.getAmount().cents(), {Field::Date, Field::Type, Field::Category, Field::Amount});
+    return true;
+}
+
+// Appends text as a JSON string literal.
+static void appendJsonString(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            out += "\\u00";
+            out += hex[(c >> 4) & 0xF];
+            out += hex[c & 0xF];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void ResultWriter::append(uint32_t id, int32_t date, uint8_t type, uint16_t category, int64_t cents,
+                          const std::vector<Field>& columns) {
+    static const char* const keys[] = {"date", "type", "category", "amount", "id"};
+    const char* separator = options.format == OutputFormat::Table ? " | " : ",";
+    const bool json = options.format == OutputFormat::JsonLines;
+
+    if (json) buffer += '{';
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (i > 0) buffer += separator;
+        if (json) {
+            buffer += '"';
+            buffer += keys[static_cast<int>(columns[i])];
+            buffer += "\":";
+        }
+
+        switch (columns[i]) {
+        case Field::Date:
+            if (json) appendJsonString(buffer, unpackDate(date));
+            else buffer += unpackDate(date);
+            break;
+        case Field::Type: {
+            const char* name = type == static_cast<uint8_t>(TransactionType::Income) ? "income" : "expense";
+            if (json) appendJsonString(buffer, name);
+            else buffer += name;
+            break;
+        }
+        case Field::Category:
+            if (json) appendJsonString(buffer, CategoryPool::name(category));
+            else buffer += CategoryPool::name(category);
+            break;
+        case Field::Amount:
+            if (options.format == OutputFormat::Table) buffer += '$';
+            buffer += Money::fromCents(cents).toString();
+            break;
+        case Field::Id:
+            if (options.format == OutputFormat::Table) buffer += '#';
+            buffer += std::to_string(id);
+            break;
+        }
+    }
+    if (json) buffer += '}';
+    buffer += '\n';
+
+    ++printedRows;
+    if (buffer.size() >= limit) flush();
+}
+
+void ResultWriter::note(const std::string& text) {
+    if (options.format != OutputFormat::Table) return;
+    buffer += text;
+    if (buffer.size() >= limit) flush();
+}
+
+void ResultWriter::finish(size_t total) {
+    if (options.format == OutputFormat::Table && printedRows > 0 && printedRows < total) {
+        size_t first = options.offset + 1;
+        note("Showing rows " + std::to_string(first) + "-" + std::to_string(first + printedRows - 1) +
+             " of " + std::to_string(total) + ".\n");
+    }
+    flush();
+}
+
+bool parseOutputFormat(const std::string& text, OutputFormat& format) {
+    if (text == "table") format = OutputFormat::Table;
+    else if (text == "csv") format = OutputFormat::Csv;
+    else if (text == "jsonl") format = OutputFormat::JsonLines;
+    else return false;
+    return true;
+}
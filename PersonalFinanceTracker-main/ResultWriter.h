@@ -0,0 +1,67 @@
+#ifndef RESULTWRITER_H
+#define RESULTWRITER_H
+#include "QueryEngine.h"
+#include "Transaction.h"
+#include "TransactionStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// How listings are printed.
+enum class OutputFormat {
+    Table,     // "date | type | category | $amount", with headings and messages
+    Csv,       // ledger lines, "date,type,category,amount", nothing else
+    JsonLines  // one {"date":...,"type":...,"category":...,"amount":...} object per line
+};
+
+// Which rows of a listing to print and how.
+struct OutputOptions {
+    OutputFormat format = OutputFormat::Table;
+    size_t offset = 0;   // matching rows skipped before the first printed one
+    size_t limit = 0;    // rows printed at most, 0 means all
+    size_t pageSize = 0; // table mode: stop every pageSize rows and ask for the next page, 0 means no paging
+};
+
+// Formats listing rows into a large buffer and writes it out in blocks, so a
+// long listing costs a few big writes instead of one flush per row. Also
+// applies offset/limit and interactive paging.
+class ResultWriter {
+public:
+    explicit ResultWriter(std::ostream& out, const OutputOptions& options = OutputOptions(),
+                          size_t bufferBytes = 1 << 16);
+    ~ResultWriter(); // flushes
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    // Offers one row. Returns false once no more rows will be printed (limit reached or the user stopped paging).
+    bool row(const TransactionStore& store, uint32_t row,
+             const std::vector<Field>& columns = {Field::Date, Field::Type, Field::Category, Field::Amount});
+    bool row(const Transaction& transaction);
+
+    void note(const std::string& text); // headings and messages, table mode only
+    void finish(size_t total);          // table mode: say which part of total rows was shown
+    void flush();
+
+    size_t printed() const { return printedRows; }
+    OutputFormat format() const { return options.format; }
+
+private:
+    bool admit();                       // offset, limit and paging for the next row
+    void append(uint32_t id, int32_t date, uint8_t type, uint16_t category, int64_t cents,
+                const std::vector<Field>& columns);
+
+    std::ostream& out;
+    OutputOptions options;
+    std::string buffer;
+    size_t limit;
+    size_t offered = 0;
+    size_t printedRows = 0;
+    bool stopped = false;
+};
+
+// Parses "table", "csv" or "jsonl". Returns false for anything else.
+bool parseOutputFormat(const std::string& text, OutputFormat& format);
+
+#endif
@@ -0,0 +1,182 @@
+#include "SegmentedLedger.h"
+#include "AtomicFile.h"
+#include "BufferedLedgerWriter.h"
+#include "PackedDate.h"
+#include "TransactionStore.h"
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+
+static const char* MANIFEST_NAME = "manifest.txt";
+
+SegmentedLedger::SegmentedLedger(std::string directory) : directory(std::move(directory)) {}
+
+std::string SegmentedLedger::segmentPath(int32_t month) const {
+    return directory + "/" + unpackMonth(month) + ".csv";
+}
+
+uint64_t SegmentedLedger::totalBytes() const {
+    uint64_t total = 0;
+    for (const auto& entry : manifest) total += entry.second.bytes;
+    return total;
+}
+
+// Whole of text as a number, like the ledger parser reads ids.
+template <typename T>
+static bool parseCount(std::string_view text, T& value) {
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end && !text.empty();
+}
+
+// Reads "YYYY-MM,rows,bytes" lines.
+bool SegmentedLedger::open(std::vector<ParseError>& skipped) {
+    manifest.clear();
+    opened = false;
+
+    std::ifstream inFile(directory + "/" + MANIFEST_NAME);
+    if (!inFile) return false;
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(inFile, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        std::string_view view(line);
+        size_t first = view.find(',');
+        size_t second = view.find(',', first == std::string_view::npos ? first : first + 1);
+        int32_t month = 0;
+        SegmentInfo info;
+        if (second == std::string_view::npos) {
+            skipped.push_back({lineNumber, "expected 3 comma-separated fields", line});
+        } else if (!packMonth(view.substr(0, first), month)) {
+            skipped.push_back({lineNumber, "bad month", line});
+        } else if (!parseCount(view.substr(first + 1, second - first - 1), info.rows) ||
+                   !parseCount(view.substr(second + 1), info.bytes)) {
+            skipped.push_back({lineNumber, "bad count", line});
+        } else {
+            manifest[month] = info;
+        }
+    }
+
+    opened = true;
+    return true;
+}
+
+bool SegmentedLedger::writeManifest() const {
+    std::string contents;
+    for (const auto& entry : manifest) {
+        contents += unpackMonth(entry.first) + "," + std::to_string(entry.second.rows) + "," +
+                    std::to_string(entry.second.bytes) + "\n";
+    }
+    return writeFileAtomically(directory + "/" + MANIFEST_NAME, contents);
+}
+
+bool SegmentedLedger::loadMonth(int32_t month, TransactionStore& store) const {
+    if (manifest.find(month) == manifest.end()) return false;
+    return store.appendFromFile(segmentPath(month), unpackMonth(month) + ".csv");
+}
+
+bool SegmentedLedger::loadAll(TransactionStore& store) const {
+    store.clear();
+    if (!opened) return false;
+    for (const auto& entry : manifest) {
+        store.appendFromFile(segmentPath(entry.first), unpackMonth(entry.first) + ".csv");
+    }
+    return true;
+}
+
+bool SegmentedLedger::append(const std::vector<Transaction>& rows, std::string& error) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    // Group by month, keeping the order within each month.
+    std::map<int32_t, std::vector<const Transaction*>> byMonth;
+    for (const Transaction& t : rows) byMonth[packedMonth(t.getDate())].push_back(&t);
+
+    bool newMonths = false;
+    for (const auto& group : byMonth) {
+        if (manifest.insert({group.first, SegmentInfo()}).second) newMonths = true;
+    }
+    if (newMonths && !writeManifest()) {
+        error = "could not write " + directory + "/" + MANIFEST_NAME;
+        return false;
+    }
+    opened = true;
+
+    for (const auto& group : byMonth) {
+        BufferedLedgerWriter writer;
+        std::string path = segmentPath(group.first);
+        if (!writer.open(path)) {
+            error = "could not open " + path;
+            return false;
+        }
+        for (const Transaction* t : group.second) writer.append(*t);
+        if (!writer.close()) {
+            error = "could not write " + path;
+            return false;
+        }
+
+        SegmentInfo& info = manifest[group.first];
+        info.rows += group.second.size();
+        info.bytes = std::filesystem::file_size(path, ec);
+    }
+
+    if (!writeManifest()) {
+        error = "could not write " + directory + "/" + MANIFEST_NAME;
+        return false;
+    }
+    return true;
+}
+
+bool SegmentedLedger::migrate(const std::string& textPath, const std::string& directory,
+                              size_t& written, size_t& skipped, std::string& error) {
+    written = skipped = 0;
+
+    std::map<int32_t, std::string> segments; // month -> file contents
+    std::map<int32_t, SegmentInfo> counts;
+
+    // Through the store, so deletions and edits in the text are applied first.
+    TransactionStore store;
+    if (!store.loadFromFile(textPath)) {
+        error = "could not open " + textPath;
+        return false;
+    }
+    skipped = store.loadErrors().size();
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (!store.isLive(i)) continue;
+        Transaction t = store.at(i);
+        int32_t month = packedMonth(t.getDate());
+        BufferedLedgerWriter::formatLine(t, segments[month]);
+        ++counts[month].rows;
+        ++written;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        error = "could not create " + directory;
+        return false;
+    }
+
+    SegmentedLedger ledger(directory);
+    for (const auto& segment : segments) {
+        std::string path = ledger.segmentPath(segment.first);
+        if (!writeFileAtomically(path, segment.second)) {
+            error = "could not write " + path;
+            return false;
+        }
+        counts[segment.first].bytes = segment.second.size();
+    }
+
+    // The manifest goes last, so an interrupted migration is simply run again.
+    ledger.manifest = std::move(counts);
+    if (!ledger.writeManifest()) {
+        error = "could not write " + directory + "/" + MANIFEST_NAME;
+        return false;
+    }
+    return true;
+}
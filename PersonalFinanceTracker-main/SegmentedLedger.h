@@ -0,0 +1,53 @@
+#ifndef SEGMENTEDLEDGER_H
+#define SEGMENTEDLEDGER_H
+#include "Transaction.h"
+#include "TransactionStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// What the manifest records about one month's segment.
+struct SegmentInfo {
+    size_t rows = 0;     // transactions in the segment
+    uint64_t bytes = 0;  // size of the segment file
+};
+
+// The ledger split into one CSV file per month (data/ledger/YYYY-MM.csv, same
+// "date,type,category,amount" lines as transactions.txt) plus a manifest
+// listing the months that exist. A monthly question reads the manifest and at
+// most one segment; only full-history queries read them all.
+class SegmentedLedger {
+public:
+    explicit SegmentedLedger(std::string directory = "data/ledger");
+
+    bool open(std::vector<ParseError>& skipped);    // read the manifest; false if there is none yet.
+                                                    // Malformed lines are left out and listed in skipped
+    bool exists() const { return opened; }
+    const std::map<int32_t, SegmentInfo>& segments() const { return manifest; } // keyed by packedMonth()
+    std::string segmentPath(int32_t month) const;   // directory/YYYY-MM.csv
+    uint64_t totalBytes() const;                    // sum of the segment sizes in the manifest
+
+    // Appends one month's segment to store. Returns false if the month has no segment.
+    bool loadMonth(int32_t month, TransactionStore& store) const;
+    // Every segment in month order; store is cleared first.
+    bool loadAll(TransactionStore& store) const;
+
+    // Routes rows to their month's segment: one write and fsync per touched segment,
+    // then one manifest update. New months are added to the manifest before their file is written.
+    bool append(const std::vector<Transaction>& rows, std::string& error);
+
+    // One-shot migration: splits a text ledger into segments under directory.
+    static bool migrate(const std::string& textPath, const std::string& directory,
+                        size_t& written, size_t& skipped, std::string& error);
+
+private:
+    bool writeManifest() const;
+
+    std::string directory;
+    std::map<int32_t, SegmentInfo> manifest;
+    bool opened = false;
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "SpendingStats.h"
+#include "PackedDate.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+static const double GAMMA = (1 + QuantileSketch::RELATIVE_ERROR) / (1 - QuantileSketch::RELATIVE_ERROR);
+static const double LOG_GAMMA = std::log(GAMMA);
+
+// Bucket i holds amounts in (GAMMA^(i-1), GAMMA^i].
+int QuantileSketch::bucketOf(int64_t cents) {
+    return static_cast<int>(std::ceil(std::log(static_cast<double>(cents)) / LOG_GAMMA));
+}
+
+void QuantileSketch::cover(int bucket) {
+    if (counts.empty()) {
+        firstBucket = bucket;
+        counts.assign(1, 0);
+    } else if (bucket < firstBucket) {
+        counts.insert(counts.begin(), static_cast<size_t>(firstBucket - bucket), 0);
+        firstBucket = bucket;
+    } else if (bucket >= firstBucket + static_cast<int>(counts.size())) {
+        counts.resize(static_cast<size_t>(bucket - firstBucket + 1), 0);
+    }
+}
+
+void QuantileSketch::add(int64_t cents) {
+    smallest = total == 0 ? cents : std::min(smallest, cents);
+    largest = total == 0 ? cents : std::max(largest, cents);
+    ++total;
+    if (cents <= 0) {
+        ++zeros;
+        return;
+    }
+    int bucket = bucketOf(cents);
+    cover(bucket);
+    ++counts[static_cast<size_t>(bucket - firstBucket)];
+}
+
+void QuantileSketch::remove(int64_t cents, int64_t largestLeft) {
+    if (total == 0) return;
+    if (--total == 0) {
+        counts.clear();
+        zeros = 0;
+        smallest = largest = 0;
+        return;
+    }
+    largest = largestLeft;
+    if (cents <= 0) {
+        if (zeros > 0) --zeros;
+    } else {
+        int bucket = bucketOf(cents);
+        if (bucket >= firstBucket && bucket < firstBucket + static_cast<int>(counts.size())) {
+            uint64_t& count = counts[static_cast<size_t>(bucket - firstBucket)];
+            if (count > 0) --count;
+        }
+    }
+
+    // The exact minimum is gone if it was removed; the lowest non-empty bucket
+    // gives it back to within RELATIVE_ERROR. Amounts <= 0 are not bucketed, so
+    // with some left the old (non-positive) minimum stays.
+    if (cents > smallest || zeros > 0) return;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] > 0) {
+            smallest = std::min(bucketValue(firstBucket + static_cast<int>(i)), largest);
+            return;
+        }
+    }
+    smallest = largest;
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.total == 0) return;
+    smallest = total == 0 ? other.smallest : std::min(smallest, other.smallest);
+    largest = total == 0 ? other.largest : std::max(largest, other.largest);
+    total += other.total;
+    zeros += other.zeros;
+    if (other.counts.empty()) return;
+
+    cover(other.firstBucket);
+    cover(other.firstBucket + static_cast<int>(other.counts.size()) - 1);
+    for (size_t i = 0; i < other.counts.size(); ++i) {
+        counts[static_cast<size_t>(other.firstBucket - firstBucket) + i] += other.counts[i];
+    }
+}
+
+// Midpoint (in the relative sense) of a bucket's range.
+int64_t QuantileSketch::bucketValue(int bucket) {
+    return static_cast<int64_t>(std::llround(2 * std::pow(GAMMA, bucket) / (GAMMA + 1)));
+}
+
+// Nearest rank: walks the buckets to the one holding the ceil(q * count)-th
+// smallest amount and returns its midpoint, clamped to the exact extremes. So
+// p99 of fewer than 100 amounts is the largest one.
+int64_t QuantileSketch::quantile(double q) const {
+    if (total == 0) return 0;
+    if (q <= 0) return smallest;
+    if (q >= 1) return largest;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total)));
+    rank = std::min(std::max<uint64_t>(rank, 1), total) - 1;
+    if (rank == total - 1) return largest;
+    if (rank < zeros) return std::min<int64_t>(smallest, 0);
+    uint64_t seen = zeros;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen > rank) return std::min(std::max(bucketValue(firstBucket + static_cast<int>(i)), smallest), largest);
+    }
+    return largest;
+}
+
+// Larger amount first; equal amounts by earlier date, then category, so the kept set never depends on order.
+static bool ranksAbove(const LargeAmount& a, const LargeAmount& b) {
+    if (a.cents != b.cents) return a.cents > b.cents;
+    if (a.date != b.date) return a.date < b.date;
+    return a.category < b.category;
+}
+
+void TopAmounts::add(const LargeAmount& entry) {
+    if (heap.size() < CAPACITY) {
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), ranksAbove);
+    } else if (ranksAbove(entry, heap.front())) {
+        std::pop_heap(heap.begin(), heap.end(), ranksAbove);
+        heap.back() = entry;
+        std::push_heap(heap.begin(), heap.end(), ranksAbove);
+    }
+}
+
+bool TopAmounts::remove(const LargeAmount& entry) {
+    for (size_t i = 0; i < heap.size(); ++i) {
+        if (heap[i].cents == entry.cents && heap[i].date == entry.date && heap[i].category == entry.category) {
+            heap.erase(heap.begin() + static_cast<std::ptrdiff_t>(i));
+            std::make_heap(heap.begin(), heap.end(), ranksAbove);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TopAmounts::merge(const TopAmounts& other) {
+    for (const LargeAmount& entry : other.heap) add(entry);
+}
+
+std::vector<LargeAmount> TopAmounts::sorted() const {
+    std::vector<LargeAmount> list = heap;
+    std::sort(list.begin(), list.end(), ranksAbove);
+    return list;
+}
+
+void SpendingStats::clear() {
+    cells.clear();
+}
+
+void SpendingStats::add(int32_t date, uint16_t category, int64_t cents) {
+    Cell& cell = cells[keyOf(packedMonth(date), category)];
+    cell.top.add({cents, date, category});
+    cell.amounts.add(cents);
+}
+
+void SpendingStats::add(const Transaction& transaction) {
+    if (transaction.getType() != TransactionType::Expense) return;
+    add(transaction.getDate(), transaction.getCategoryId(), transaction.getAmount().cents());
+}
+
+// If the row was one of its cell's largest and the cell was full, the amount
+// that now belongs in the top list was never kept, so the list is rebuilt
+// from the other live rows of that category in that month.
+void SpendingStats::remove(const Transaction& transaction, uint32_t row, const TransactionStore& store,
+                           const DateIndex& dateIndex) {
+    if (transaction.getType() != TransactionType::Expense) return;
+    int32_t month = packedMonth(transaction.getDate());
+    uint16_t category = transaction.getCategoryId();
+    auto it = cells.find(keyOf(month, category));
+    if (it == cells.end()) return;
+
+    Cell& cell = it->second;
+    int64_t cents = transaction.getAmount().cents();
+    bool wasFull = cell.top.size() == TopAmounts::CAPACITY;
+    if (cell.top.remove({cents, transaction.getDate(), category}) && wasFull) {
+        cell.top = TopAmounts();
+        DateIndex::Range rows = dateIndex.between(month * 32, month * 32 + 31);
+        for (const uint32_t* p = rows.begin; p != rows.end; ++p) {
+            if (*p == row || store.categories()[*p] != category ||
+                store.types()[*p] != static_cast<uint8_t>(TransactionType::Expense)) continue;
+            cell.top.add({store.cents()[*p], store.dates()[*p], category});
+        }
+    }
+
+    std::vector<LargeAmount> top = cell.top.sorted();
+    cell.amounts.remove(cents, top.empty() ? 0 : top.front().cents);
+    if (cell.amounts.count() == 0) cells.erase(it);
+}
+
+void SpendingStats::merge(const SpendingStats& other) {
+    for (const auto& entry : other.cells) {
+        Cell& cell = cells[entry.first];
+        cell.top.merge(entry.second.top);
+        cell.amounts.merge(entry.second.amounts);
+    }
+}
+
+// Straight off the columns, live expense rows only.
+void SpendingStats::addRows(const TransactionStore& store, size_t begin, size_t end) {
+    const std::vector<int32_t>& dates = store.dates();
+    const std::vector<uint8_t>& types = store.types();
+    const std::vector<uint16_t>& categories = store.categories();
+    const std::vector<int64_t>& cents = store.cents();
+    const std::vector<uint8_t>& live = store.live();
+    for (size_t row = begin; row < end; ++row) {
+        if (live[row] && types[row] == static_cast<uint8_t>(TransactionType::Expense)) add(dates[row], categories[row], cents[row]);
+    }
+}
+
+void SpendingStats::rebuild(const TransactionStore& store, unsigned threads) {
+    const size_t MIN_CHUNK_ROWS = 1 << 18;
+    clear();
+    size_t rows = store.size();
+    size_t chunks = std::min<size_t>(rows / MIN_CHUNK_ROWS, threads == 0 ? ThreadPool::defaultThreads() : threads);
+    if (chunks <= 1) {
+        addRows(store, 0, rows);
+        return;
+    }
+
+    std::vector<SpendingStats> parts(chunks);
+    {
+        ThreadPool pool(static_cast<unsigned>(chunks));
+        for (size_t i = 0; i < chunks; ++i) {
+            SpendingStats* part = &parts[i];
+            size_t begin = rows * i / chunks, end = rows * (i + 1) / chunks;
+            pool.submit([part, &store, begin, end] { part->addRows(store, begin, end); });
+        }
+        pool.wait();
+    }
+    for (const SpendingStats& part : parts) merge(part);
+}
+
+std::vector<LargeAmount> SpendingStats::largest(size_t n, std::optional<int32_t> month,
+                                                std::optional<uint16_t> category) const {
+    TopAmounts top;
+    for (const auto& entry : cells) {
+        if (month && static_cast<int32_t>(entry.first >> 16) != *month) continue;
+        if (!category || (entry.first & 0xFFFF) == *category) top.merge(entry.second.top);
+    }
+    std::vector<LargeAmount> list = top.sorted();
+    if (list.size() > n) list.resize(n);
+    return list;
+}
+
+std::map<uint16_t, QuantileSketch> SpendingStats::byCategory(std::optional<int32_t> month) const {
+    std::map<uint16_t, QuantileSketch> sketches;
+    for (const auto& entry : cells) {
+        if (month && static_cast<int32_t>(entry.first >> 16) != *month) continue;
+        sketches[static_cast<uint16_t>(entry.first & 0xFFFF)].merge(entry.second.amounts);
+    }
+    return sketches;
+}
@@ -0,0 +1,95 @@
+#ifndef SPENDINGSTATS_H
+#define SPENDINGSTATS_H
+#include "DateIndex.h"
+#include "Transaction.h"
+#include "TransactionStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Distribution of amounts in log-spaced buckets (the DDSketch idea). Every
+// quantile it returns is within RELATIVE_ERROR of a true one, its size depends
+// on how widely amounts are spread rather than how many there are, and two
+// sketches merge by adding their bucket counts.
+class QuantileSketch {
+public:
+    void add(int64_t cents);
+    void remove(int64_t cents, int64_t largestLeft); // largestLeft: the largest amount still counted, which
+                                                     // the buckets only know approximately
+    void merge(const QuantileSketch& other);
+    uint64_t count() const { return total; }
+    int64_t quantile(double q) const;   // q in [0, 1], in cents; 0 when empty
+    int64_t max() const { return largest; }
+
+    static constexpr double RELATIVE_ERROR = 0.01;
+
+private:
+    static int bucketOf(int64_t cents);
+    static int64_t bucketValue(int bucket); // representative amount of a bucket
+    void cover(int bucket);             // grow counts so bucket has a slot
+
+    std::vector<uint64_t> counts;       // counts[i] is bucket firstBucket + i
+    int firstBucket = 0;
+    uint64_t zeros = 0;                 // amounts <= 0, which have no log bucket
+    uint64_t total = 0;
+    int64_t smallest = 0, largest = 0;  // exact, so q = 0 and q = 1 are exact too
+};
+
+// One of the largest expenses.
+struct LargeAmount {
+    int64_t cents;
+    int32_t date;       // packed
+    uint16_t category;  // CategoryPool id
+};
+
+// The CAPACITY largest amounts seen, in a heap whose front is the smallest kept.
+class TopAmounts {
+public:
+    void add(const LargeAmount& entry);
+    bool remove(const LargeAmount& entry);     // false if it was not among the kept amounts
+    void merge(const TopAmounts& other);
+    size_t size() const { return heap.size(); }
+    std::vector<LargeAmount> sorted() const;  // largest first, then earlier date
+
+    static const size_t CAPACITY = 10;
+
+private:
+    std::vector<LargeAmount> heap;
+};
+
+// Expense statistics per (month, category): the largest expenses and a sketch
+// of the amounts. Kept in step with every append like AggregateTable, so an
+// answer costs the same however long the ledger is: it merges at most one
+// small cell per month and category. Removing a row that was among a cell's
+// largest refills that cell from the month's rows, the only time it reads them.
+class SpendingStats {
+public:
+    void clear();
+    void add(const Transaction& transaction);    // income rows are ignored
+    void remove(const Transaction& transaction, uint32_t row, const TransactionStore& store,
+                const DateIndex& dateIndex);     // undo add() for row, which is about to be deleted or replaced
+    void merge(const SpendingStats& other);
+    void rebuild(const TransactionStore& store, unsigned threads); // row chunks on a pool, merged in order
+
+    // Up to n (at most TopAmounts::CAPACITY) largest expenses; no month or category means all of them.
+    std::vector<LargeAmount> largest(size_t n, std::optional<int32_t> month, std::optional<uint16_t> category) const;
+    std::map<uint16_t, QuantileSketch> byCategory(std::optional<int32_t> month) const; // category id -> amounts
+
+private:
+    struct Cell {
+        TopAmounts top;
+        QuantileSketch amounts;
+    };
+
+    void add(int32_t date, uint16_t category, int64_t cents);
+    void addRows(const TransactionStore& store, size_t begin, size_t end);
+
+    static uint32_t keyOf(int32_t month, uint16_t category) { return static_cast<uint32_t>(month) << 16 | category; }
+
+    std::unordered_map<uint32_t, Cell> cells; // keyOf(packedMonth(), category id) -> cell
+};
+
+#endif
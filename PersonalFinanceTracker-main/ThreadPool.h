@@ -0,0 +1,37 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling tasks from a queue.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);  // 0 means one per hardware thread
+    ~ThreadPool();                          // finishes queued tasks, then joins
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();                            // block until every submitted task has run
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    static unsigned defaultThreads();       // hardware_concurrency, at least 1
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable allDone;
+    size_t pending = 0;                     // queued + running
+    bool stopping = false;
+};
+
+#endif
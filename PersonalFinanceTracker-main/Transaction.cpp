@@ -1,31 +1,53 @@
 #include "Transaction.h"
+#include "CategoryPool.h"
+#include "PackedDate.h"
 #include <iostream>
+#include <utility>
 
 // Constructor implementation: sets up a transaction using an initialization list.
-Transaction::Transaction(std::string type, double amount, std::string category, std::string date)
-    : type(type), amount(amount), category(category), date(date) {}
+Transaction::Transaction(TransactionType type, Money amount, uint16_t categoryId, int32_t date)
+    : amount(amount), date(date), categoryId(categoryId), type(type) {}
+
+// Constructor implementation: converts the text fields once, up front.
+Transaction::Transaction(std::string_view type, Money amount, std::string category, std::string_view date)
+    : amount(amount),
+      date(0),
+      categoryId(CategoryPool::intern(std::move(category))),
+      type(type == "income" ? TransactionType::Income : TransactionType::Expense) {
+    packDate(date, this->date);
+}
 
 // Getter for transaction type.
-std::string Transaction::getType() const {
+TransactionType Transaction::getType() const {
     return type;
 }
 
+// Getter for the type as text.
+const char* Transaction::getTypeName() const {
+    return type == TransactionType::Income ? "income" : "expense";
+}
+
 // Getter for transaction amount.
-double Transaction::getAmount() const {
+Money Transaction::getAmount() const {
     return amount;
 }
 
+// Getter for transaction category id.
+uint16_t Transaction::getCategoryId() const {
+    return categoryId;
+}
+
 // Getter for transaction category.
-std::string Transaction::getCategory() const {
-    return category;
+std::string_view Transaction::getCategory() const {
+    return CategoryPool::name(categoryId);
 }
 
 // Getter for transaction date.
-std::string Transaction::getDate() const {
+int32_t Transaction::getDate() const {
     return date;
 }
 
 // Display method: Prints the transaction details to the console.
 void Transaction::display() const {
-    std::cout << date << " | " << type << " | " << category << " | $" << amount << std::endl;
+    std::cout << unpackDate(date) << " | " << getTypeName() << " | " << getCategory() << " | $" << getAmount() << '\n';
 }
@@ -1,28 +1,46 @@
 #ifndef TRANSACTION_H
 #define TRANSACTION_H
 
+#include "Money.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 
-// Transaction class: Represents a single financial transaction (income or expense)
+// Whether money came in or went out.
+enum class TransactionType : uint8_t {
+    Expense = 0,
+    Income = 1
+};
+
+// Transaction class: Represents a single financial transaction (income or expense).
+// Stored compactly (16 bytes): text is only produced when the transaction is displayed.
 class Transaction {
 public:
-    // Constructor: Initializes a transaction with a type, amount, category, and date.
-    Transaction(std::string type, double amount, std::string category, std::string date);
+    // Constructor: Builds a transaction from its compact parts.
+    Transaction(TransactionType type, Money amount, uint16_t categoryId, int32_t date);
 
-    // Getter functions to return private data members.
-    std::string getType() const;
-    double getAmount() const;
-    std::string getCategory() const;
-    std::string getDate() const;
+    // Constructor: Builds a transaction from user-facing text ("expense", 12.50, "Groceries", "2025-04-02").
+    // The category is interned and the date packed; a type other than "income" is treated as an expense.
+    Transaction(std::string_view type, Money amount, std::string category, std::string_view date);
+
+    // Getter functions. None of them allocate.
+    TransactionType getType() const;
+    const char* getTypeName() const;         // "income" or "expense"
+    Money getAmount() const;                 // fixed-point amount
+    uint16_t getCategoryId() const;          // id in CategoryPool
+    std::string_view getCategory() const;    // interned category name
+    int32_t getDate() const;                 // packed date, see PackedDate.h
 
     // Display function: Outputs the transaction details in a user-friendly way.
     void display() const;
 
 private:
-    std::string type;      // "income" or "expense"
-    double amount;         // Transaction amount (should be positive ideally)
-    std::string category;  // Transaction category (e.g., "Food", "Rent")
-    std::string date;      // Transaction date in YYYY-MM-DD format
+    Money amount;          // Transaction amount (should be positive ideally)
+    int32_t date;          // Packed YYYY-MM-DD
+    uint16_t categoryId;   // Interned category (e.g., "Groceries", "Salary")
+    TransactionType type;  // Income or expense
 };
 
+static_assert(sizeof(Transaction) == 16, "Transaction should stay 16 bytes");
+
 #endif
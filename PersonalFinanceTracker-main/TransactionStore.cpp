@@ -0,0 +1,206 @@
+#include "TransactionStore.h"
+#include "BinaryLedger.h"
+#include "CategoryPool.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <utility>
+
+// Reads every line of the ledger into memory. Malformed lines are skipped and reported.
+bool TransactionStore::loadFromFile(const std::string& path) {
+    clear();
+
+    LedgerParser parser;
+    bool opened = parser.parseFile(path, [this](const LedgerRow& row) { apply(row); }, errors);
+    if (!opened) return false;
+
+    loaded = true;
+    return true;
+}
+
+// Adds the rows of another ledger file after the ones already held.
+bool TransactionStore::appendFromFile(const std::string& path, const std::string& label) {
+    size_t firstError = errors.size();
+
+    LedgerParser parser;
+    bool opened = parser.parseFile(path, [this](const LedgerRow& row) { apply(row); }, errors);
+
+    for (size_t i = firstError; i < errors.size(); ++i) {
+        errors[i].message = label + ": " + errors[i].message;
+    }
+    loaded = true;
+    return opened;
+}
+
+// Adds a transaction or applies a '#' record. A record naming a row that is
+// not live (or not written yet at that point) is reported like a bad line.
+void TransactionStore::apply(const LedgerRow& row) {
+    bool ok = true;
+    if (row.kind == LedgerRowKind::Gap) {
+        appendGap(row.target);
+    } else if (row.kind == LedgerRowKind::Unreadable) {
+        appendGap(1);
+    } else if (row.kind == LedgerRowKind::Delete) {
+        ok = remove(row.target);
+    } else {
+        Transaction transaction(row.transactionType, row.amount, CategoryPool::intern(row.category), row.packedDate);
+        if (row.kind == LedgerRowKind::Transaction) append(transaction);
+        else ok = replace(row.target, transaction);
+    }
+    if (!ok) errors.push_back({row.lineNumber, "no live transaction with id " + std::to_string(row.target),
+                               std::string(row.text)});
+}
+
+// Reads a binary ledger. Records are decoded straight out of the mapping.
+// error is left empty when the file simply does not exist yet.
+bool TransactionStore::loadFromBinaryFile(const std::string& path, std::string& error) {
+    clear();
+
+    BinaryLedgerReader reader;
+    if (!reader.open(path, error)) {
+        if (error.rfind("could not open", 0) == 0) error.clear();
+        return false;
+    }
+
+    reserve(reader.size());
+    Profiler::count(Profiler::Counter::BytesRead, sizeof(BinaryLedgerHeader) + reader.size() * sizeof(BinaryRecord));
+    for (size_t i = 0; i < reader.size(); ++i) {
+        append(reader.toTransaction(reader.record(i)));
+    }
+
+    loaded = true;
+    return true;
+}
+
+// Keeps the cache in step with a row that was just appended to the file.
+void TransactionStore::append(const Transaction& transaction) {
+    dateColumn.push_back(transaction.getDate());
+    typeColumn.push_back(static_cast<uint8_t>(transaction.getType()));
+    categoryColumn.push_back(transaction.getCategoryId());
+    centsColumn.push_back(transaction.getAmount().cents());
+    liveColumn.push_back(1);
+    loaded = true;
+}
+
+void TransactionStore::appendGap(size_t count) {
+    dateColumn.insert(dateColumn.end(), count, 0);
+    typeColumn.insert(typeColumn.end(), count, 0);
+    categoryColumn.insert(categoryColumn.end(), count, 0);
+    centsColumn.insert(centsColumn.end(), count, 0);
+    liveColumn.insert(liveColumn.end(), count, 0);
+    deadRows += count;
+}
+
+bool TransactionStore::remove(size_t row) {
+    if (!isLive(row)) return false;
+    liveColumn[row] = 0;
+    centsColumn[row] = 0;
+    ++deadRows;
+    ++removed;
+    ++edits;
+    return true;
+}
+
+bool TransactionStore::replace(size_t row, const Transaction& transaction) {
+    if (!isLive(row)) return false;
+    dateColumn[row] = transaction.getDate();
+    typeColumn[row] = static_cast<uint8_t>(transaction.getType());
+    categoryColumn[row] = transaction.getCategoryId();
+    centsColumn[row] = transaction.getAmount().cents();
+    ++edits;
+    return true;
+}
+
+// After a compaction the removed rows are gaps in the file and the edit records are gone.
+void TransactionStore::compacted(size_t removedRows, size_t editRecords) {
+    removed -= std::min(removed, removedRows);
+    edits -= std::min(edits, editRecords);
+}
+
+void TransactionStore::clear() {
+    dateColumn.clear();
+    typeColumn.clear();
+    categoryColumn.clear();
+    centsColumn.clear();
+    liveColumn.clear();
+    deadRows = removed = edits = 0;
+    errors.clear();
+    loaded = false;
+}
+
+void TransactionStore::appendChunk(const TransactionStore& chunk, const std::vector<uint16_t>& categoryRemap) {
+    dateColumn.insert(dateColumn.end(), chunk.dateColumn.begin(), chunk.dateColumn.end());
+    typeColumn.insert(typeColumn.end(), chunk.typeColumn.begin(), chunk.typeColumn.end());
+    centsColumn.insert(centsColumn.end(), chunk.centsColumn.begin(), chunk.centsColumn.end());
+    liveColumn.insert(liveColumn.end(), chunk.liveColumn.begin(), chunk.liveColumn.end());
+    deadRows += chunk.deadRows;
+    removed += chunk.removed;
+    edits += chunk.edits;
+    categoryColumn.reserve(categoryColumn.size() + chunk.categoryColumn.size());
+    for (uint16_t local : chunk.categoryColumn) {
+        categoryColumn.push_back(categoryRemap[local]);
+    }
+}
+
+// Restores whole columns at once (from a snapshot).
+void TransactionStore::appendColumns(const std::vector<int32_t>& dates, const std::vector<uint8_t>& types,
+                                     const std::vector<uint16_t>& categories, const std::vector<int64_t>& cents,
+                                     const std::vector<uint8_t>& live) {
+    dateColumn.insert(dateColumn.end(), dates.begin(), dates.end());
+    typeColumn.insert(typeColumn.end(), types.begin(), types.end());
+    categoryColumn.insert(categoryColumn.end(), categories.begin(), categories.end());
+    centsColumn.insert(centsColumn.end(), cents.begin(), cents.end());
+    liveColumn.insert(liveColumn.end(), live.begin(), live.end());
+    deadRows += static_cast<size_t>(std::count(live.begin(), live.end(), 0));
+}
+
+void TransactionStore::restoreEditCounts(size_t removedRows, size_t editRecords) {
+    removed = removedRows;
+    edits = editRecords;
+}
+
+void TransactionStore::finishLoad(std::vector<ParseError> skipped) {
+    errors = std::move(skipped);
+    loaded = true;
+}
+
+void TransactionStore::reserve(size_t rows) {
+    dateColumn.reserve(rows);
+    typeColumn.reserve(rows);
+    categoryColumn.reserve(rows);
+    centsColumn.reserve(rows);
+    liveColumn.reserve(rows);
+}
+
+// Gathers one row back out of the columns.
+Transaction TransactionStore::at(size_t row) const {
+    return Transaction(static_cast<TransactionType>(typeColumn[row]), Money::fromCents(centsColumn[row]),
+                       categoryColumn[row], dateColumn[row]);
+}
+
+size_t TransactionStore::size() const {
+    return centsColumn.size();
+}
+
+bool TransactionStore::isLoaded() const {
+    return loaded;
+}
+
+const std::vector<ParseError>& TransactionStore::loadErrors() const {
+    return errors;
+}
+
+// One line per malformed row skipped by the last load.
+void TransactionStore::printLoadErrors(std::ostream& out) const {
+    for (const ParseError& e : errors) {
+        out << "Skipping invalid transaction on line " << e.lineNumber
+                  << " (" << e.message << "): " << e.text << "\n";
+    }
+}
+
+// Income and expense over every row.
+void TransactionStore::totals(Money& income, Money& expense) const {
+    int64_t in = 0, out = 0;
+    sumCentsByType(centsColumn.data(), typeColumn.data(), size(), in, out);
+    income = Money::fromCents(in);
+    expense = Money::fromCents(out);
+}
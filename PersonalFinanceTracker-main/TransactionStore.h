@@ -0,0 +1,73 @@
+#ifndef TRANSACTIONSTORE_H
+#define TRANSACTIONSTORE_H
+#include "Transaction.h"
+#include "LedgerParser.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// In-memory copy of the transaction ledger. Loaded once from disk and kept
+// in sync with every append, so queries never have to re-read the file.
+// Rows are stored column by column so scans and sums walk contiguous arrays.
+// A row's position is its transaction id. Deleted rows (and gaps left by
+// compaction or unreadable lines) keep their slot so later ids never move; they are flagged dead
+// and their amount is zeroed, so sums over the columns need no check.
+class TransactionStore {
+public:
+    bool loadFromFile(const std::string& path);  // read the whole ledger once
+    bool loadFromBinaryFile(const std::string& path, std::string& error); // same, from a memory-mapped binary ledger
+    bool appendFromFile(const std::string& path, const std::string& label); // parse one more file (a month segment) onto the end;
+                                                                            // its errors are tagged with label
+    void append(const Transaction& transaction); // add a newly saved row
+    void appendGap(size_t count);                // dead rows standing for ids removed by compaction or unreadable lines
+    bool remove(size_t row);                     // #delete: false if row is not a live row
+    bool replace(size_t row, const Transaction& transaction); // #replace: same id, new contents; false if not live
+    void compacted(size_t removed, size_t edits); // that many removals and edit records were folded into the file
+    void clear();
+
+    // Used by loaders that parse in pieces: append a chunk whose category ids are
+    // translated through categoryRemap, then mark the load finished.
+    void appendChunk(const TransactionStore& chunk, const std::vector<uint16_t>& categoryRemap);
+    void finishLoad(std::vector<ParseError> skipped);
+    void appendColumns(const std::vector<int32_t>& dates, const std::vector<uint8_t>& types,
+                       const std::vector<uint16_t>& categories, const std::vector<int64_t>& cents,
+                       const std::vector<uint8_t>& live);  // CategoryPool ids
+    void restoreEditCounts(size_t removed, size_t edits);  // counters saved with the columns
+
+    Transaction at(size_t row) const;            // rebuild one row (rows are in file order)
+    size_t size() const;                         // rows including dead ones, i.e. the next id
+    bool isLive(size_t row) const { return row < liveColumn.size() && liveColumn[row]; }
+    size_t liveRows() const { return size() - deadRows; }
+    size_t removedRows() const { return removed; }  // deleted since the ledger was last compacted
+    size_t editRecords() const { return edits; }    // #delete/#replace lines in the ledger
+    bool isLoaded() const;                       // false if the file could not be opened
+    const std::vector<ParseError>& loadErrors() const; // malformed lines skipped by the last load
+    void printLoadErrors(std::ostream& out = std::cout) const;
+
+    // Column views, one entry per row.
+    const std::vector<int32_t>& dates() const { return dateColumn; }
+    const std::vector<uint8_t>& types() const { return typeColumn; }        // TransactionType values
+    const std::vector<uint16_t>& categories() const { return categoryColumn; }
+    const std::vector<int64_t>& cents() const { return centsColumn; }
+    const std::vector<uint8_t>& live() const { return liveColumn; }         // 1 live, 0 deleted or gap
+
+    void totals(Money& income, Money& expense) const; // whole ledger, via the SIMD kernel
+
+private:
+    void reserve(size_t rows);
+    void apply(const LedgerRow& row);     // one parsed line of loadFromFile/appendFromFile
+
+    std::vector<int32_t> dateColumn;      // packed dates
+    std::vector<uint8_t> typeColumn;      // 0 expense, 1 income
+    std::vector<uint16_t> categoryColumn; // CategoryPool ids
+    std::vector<int64_t> centsColumn;     // amounts in cents
+    std::vector<uint8_t> liveColumn;      // 0 for deleted rows and gaps
+    size_t deadRows = 0;
+    size_t removed = 0;
+    size_t edits = 0;
+    std::vector<ParseError> errors;
+    bool loaded = false;
+};
+
+#endif
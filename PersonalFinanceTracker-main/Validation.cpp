@@ -0,0 +1,35 @@
+#include "Validation.h"
+#include "CategoryRegistry.h"
+#include <cctype>              // isdigit
+
+// Validate YYYY-MM-DD
+bool isValidDate(const std::string& s) {
+    if (s.size() != 10 || s[4] != '-' || s[7] != '-') return false;
+    for (int i : {0,1,2,3,5,6,8,9})
+        if (!std::isdigit(s[i])) return false;
+
+    int month = std::stoi(s.substr(5, 2));
+    int day = std::stoi(s.substr(8, 2));
+
+    if (month < 1 || month > 12) return false;
+    if (day < 1 || day > 31) return false;
+
+    return true;
+}
+
+// Validate YYYY-MM
+bool isValidMonth(const std::string& s) {
+    if (s.size() != 7 || s[4] != '-') return false;
+    for (int i : {0,1,2,3,5,6})
+        if (!std::isdigit(s[i])) return false;
+
+    int monthNum = std::stoi(s.substr(5, 2));
+    return monthNum >= 1 && monthNum <= 12;
+}
+
+// Category must be registered for its type
+bool isValidCategory(const std::string& type, const std::string& category) {
+    uint16_t id = 0;
+    return CategoryRegistry::find(category, id) &&
+           CategoryRegistry::allows(id, type == "expense" ? TransactionType::Expense : TransactionType::Income);
+}
@@ -0,0 +1,16 @@
+#ifndef VALIDATION_H
+#define VALIDATION_H
+#include <string>
+
+// Input rules shared by the interactive prompts and the bulk importer.
+
+// Validate YYYY-MM-DD
+bool isValidDate(const std::string& s);
+
+// Validate YYYY-MM
+bool isValidMonth(const std::string& s);
+
+// Category must be one of the predefined ones for its type ("income" or "expense")
+bool isValidCategory(const std::string& type, const std::string& category);
+
+#endif
@@ -0,0 +1,220 @@
+// Benchmark for FinanceManager. Generates synthetic ledgers at several sizes
+// (see LedgerGenerator.h) and times every operation on each of them.
+//
+// Build from the project folder (everything except main.cpp, plus this file):
+//   g++ -std=c++17 -O2 -pthread -I. bench/Benchmark.cpp $(ls *.cpp | grep -v '^main.cpp$') -o bench.exe
+// Run:
+//   bench.exe [rows ...] [--seed S] [--dir D] [--min-time SECONDS]
+// Default sizes are 1000 10000 100000 1000000. Ledgers are written to D/<rows>/data
+// (default bench_data) and reused if they already exist with the same seed.
+
+#include "BinaryLedger.h"
+#include "FinanceManager.h"
+#include "LedgerGenerator.h"
+#include "PackedDate.h"
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Swallows console output while an operation is timed, counting the bytes.
+class CountingBuffer : public std::streambuf {
+public:
+    uint64_t bytes = 0;
+
+protected:
+    int overflow(int c) override {
+        if (c != traits_type::eof()) ++bytes;
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        bytes += static_cast<uint64_t>(n);
+        return n;
+    }
+};
+
+// Highest resident set size of this process so far, in bytes.
+static uint64_t peakRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+struct Options {
+    std::vector<uint64_t> sizes;
+    uint64_t seed = 42;
+    std::string dir = "bench_data";
+    double minTime = 0.2;   // repeat quick operations until this many seconds have passed
+};
+
+// Times fn, repeating it until minTime has passed (at most 1000 calls), and prints one table row.
+// rows and fileBytes describe the ledger; output bytes are counted from what fn prints.
+static void measure(const std::string& name, uint64_t rows, uint64_t fileBytes, bool countOutput,
+                    double minTime, const std::function<void()>& fn) {
+    CountingBuffer sink;
+    std::streambuf* console = std::cout.rdbuf(&sink);
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    double elapsed = 0;
+    int calls = 0;
+    do {
+        fn();
+        ++calls;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < minTime && calls < 1000);
+
+    std::cout.rdbuf(console);
+
+    double perCall = elapsed / calls;
+    uint64_t bytes = countOutput ? sink.bytes / static_cast<uint64_t>(calls) : fileBytes;
+    std::cout << std::left << std::setw(26) << name << std::right
+              << std::setw(7) << calls
+              << std::setw(13) << std::fixed << std::setprecision(3) << perCall * 1000.0
+              << std::setw(17) << std::setprecision(0) << (perCall > 0 ? rows / perCall : 0.0)
+              << std::setw(11) << std::setprecision(1) << (perCall > 0 ? bytes / perCall / 1048576.0 : 0.0)
+              << std::setw(11) << std::setprecision(1) << peakRss() / 1048576.0 << "\n";
+}
+
+// Generates (or reuses) the ledger for one size inside dir/<rows>/data.
+static bool prepare(const Options& options, uint64_t rows, fs::path& workDir) {
+    workDir = fs::path(options.dir) / std::to_string(rows);
+    fs::create_directories(workDir / "data");
+
+    fs::path ledger = workDir / "data" / "transactions.txt";
+    fs::path stamp = workDir / "data" / "seed.txt";
+    std::ifstream stampIn(stamp);
+    uint64_t existingSeed = 0;
+    if (fs::exists(ledger) && (stampIn >> existingSeed) && existingSeed == options.seed) return true;
+
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    if (!LedgerGenerator::writeText(ledger.string(), rows, options.seed, error)) {
+        std::cout << "Error: " << error << "\n";
+        return false;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::ofstream(stamp) << options.seed << "\n";
+    std::remove((workDir / "data" / "transactions.bin").string().c_str());
+
+    std::cout << "Generated " << rows << " rows (" << std::fixed << std::setprecision(1)
+              << fs::file_size(ledger) / 1048576.0 << " MB) in " << std::setprecision(3) << seconds << " s\n";
+    return true;
+}
+
+static void runScale(const Options& options, uint64_t rows) {
+    fs::path workDir;
+    if (!prepare(options, rows, workDir)) return;
+
+    fs::path home = fs::current_path();
+    fs::current_path(workDir);
+
+    uint64_t textBytes = fs::file_size("data/transactions.txt");
+    double minTime = options.minTime;
+
+    // Query arguments in the middle of the generated period (2016-2025).
+    const std::string month = "2021-01";
+    const std::string day = "2021-01-15";
+
+    std::cout << "\n== " << rows << " rows, " << std::fixed << std::setprecision(1)
+              << textBytes / 1048576.0 << " MB ==\n";
+    std::cout << std::left << std::setw(26) << "operation" << std::right << std::setw(7) << "calls"
+              << std::setw(13) << "ms/call" << std::setw(17) << "rows/s"
+              << std::setw(11) << "MB/s" << std::setw(11) << "peak MB" << "\n";
+
+    measure("load (text, all cores)", rows, textBytes, false, 0, [] { FinanceManager manager; manager.waitUntilLoaded(); });
+    measure("load (text, 1 thread)", rows, textBytes, false, 0,
+            [] { FinanceManager manager(LedgerFormat::Text, 1); manager.waitUntilLoaded(); });
+
+    {
+        FinanceManager manager;
+        manager.waitUntilLoaded();
+
+        measure("getMonthlyExpenseTotal", rows, 0, true, minTime, [&] { manager.getMonthlyExpenseTotal(month); });
+        measure("generateMonthlyReport", rows, 0, true, minTime, [&] { manager.generateMonthlyReport(month); });
+        measure("showExpenseBarChart", rows, 0, true, minTime, [&] { manager.showExpenseBarChart(month); });
+        measure("filterByCategory", rows, 0, true, minTime,
+                [&] { manager.filterTransactionsByCategory("Holidays"); });
+        measure("filterByCategories", rows, 0, true, minTime,
+                [&] { manager.filterTransactionsByCategories({"Charity", "Holidays"}); });
+        measure("filterByDate", rows, 0, true, minTime, [&] { manager.filterTransactionsByDate(day); });
+        measure("filterByDateRange", rows, 0, true, minTime,
+                [&] { manager.filterTransactionsByDateRange("2021-01-01", "2021-03-31"); });
+        measure("filterByAmount", rows, 0, true, minTime,
+                [&] { manager.filterTransactionsByAmount(Money::fromCents(250000), true); });
+        measure("searchTransactions", rows, 0, true, minTime, [&] {
+            int32_t from = 0, to = 0;
+            packDate("2020-01-01", from);
+            packDate("2020-12-31", to);
+            Query query;
+            query.where = Predicate::allOf({Predicate::dateRange(from, to),
+                                            Predicate::type(TransactionType::Expense),
+                                            Predicate::amountAtLeast(Money::fromCents(10000))});
+            query.order = SortOrder::AmountDescending;
+            manager.searchTransactions(query);
+        });
+        measure("loadTransactionsFromFile", rows, 0, true, 0, [&] { manager.loadTransactionsFromFile(); });
+    }
+
+    std::string error;
+    size_t written = 0, skipped = 0;
+    if (!fs::exists("data/transactions.bin") &&
+        !BinaryLedger::convertTextToBinary("data/transactions.txt", "data/transactions.bin", written, skipped, error)) {
+        std::cout << "Error: " << error << "\n";
+    } else {
+        uint64_t binaryBytes = fs::file_size("data/transactions.bin");
+        measure("load (binary)", rows, binaryBytes, false, 0, [] { FinanceManager manager(LedgerFormat::Binary); manager.waitUntilLoaded(); });
+    }
+
+    fs::current_path(home);
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--dir" && i + 1 < argc) {
+            options.dir = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.minTime = std::stod(argv[++i]);
+        } else if (!arg.empty() && std::isdigit(static_cast<unsigned char>(arg[0]))) {
+            options.sizes.push_back(std::stoull(arg));
+        } else {
+            std::cout << "Usage: bench.exe [rows ...] [--seed S] [--dir D] [--min-time SECONDS]\n";
+            return 1;
+        }
+    }
+    if (options.sizes.empty()) options.sizes = {1000, 10000, 100000, 1000000};
+
+    for (uint64_t rows : options.sizes) runScale(options, rows);
+    return 0;
+}
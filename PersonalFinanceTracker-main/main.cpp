@@ -5,8 +5,28 @@
 #include <cctype>              // ::tolower, isdigit
 #include <limits>              // numeric limits 
 #include <sstream>             // std::stringstream
+#include <optional>            // std::optional
+#include <utility>             // std::move
 #include "Transaction.h"       // Transaction class
 #include "FinanceManager.h"    // FinanceManager class
+#include "BinaryLedger.h"      // ledger format converters
+#include "SegmentedLedger.h"   // --to-segments
+#include "CategoryRegistry.h"  // predefined categories
+#include "PackedDate.h"        // packDate
+#include "Validation.h"        // isValidDate, isValidMonth
+#include "ResultWriter.h"      // buffered listings, paging, csv/jsonl
+#include "LedgerGenerator.h"   // synthetic ledgers
+#include "Profiler.h"          // --stats
+#include "LedgerDaemon.h"      // --daemon, --client
+#include <fstream>             // --stats-json
+#include <charconv>            // std::from_chars
+#include <cstring>             // std::strlen
+#include <cstdlib>             // std::strtod
+#include <cerrno>              // ERANGE
+
+static const char* SOCKET_PATH = "data/tracker.sock"; // where --daemon listens
+static const unsigned MAX_THREADS = 1024; // --threads beyond this is a typo, not a machine
+static const char* BUDGET_REPORT_PATH = "data/budget_report.csv"; // default for exporting the budget report
 
 // Helper to get a valid integer between min and max
 int getValidInt(int min, int max, const std::string& prompt) {
@@ -25,16 +45,18 @@ int getValidInt(int min, int max, const std::string& prompt) {
     }
 }
 
-// Helper to get a valid double >= min
+// Helper to get a valid amount >= min. Anything past Money::MAX_DOLLARS is refused,
+// since it could not be stored in cents.
 double getValidDouble(double min, const std::string& prompt) {
     double value;
     while (true) {
         std::cout << prompt;
         std::cin >> value;
-        if (std::cin.fail() || value < min) {
+        if (std::cin.fail() || !(value >= min && value <= Money::MAX_DOLLARS)) {
             std::cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::cout << "Please enter a number >= " << min << ".\n";
+            std::cout << "Please enter a number between " << min << " and "
+                      << static_cast<long long>(Money::MAX_DOLLARS) << ".\n";
         } else {
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             return value;
@@ -42,22 +64,6 @@ double getValidDouble(double min, const std::string& prompt) {
     }
 }
 
-// Validate YYYY-MM-DD
-bool isValidDate(const std::string& s) {
-    if (s.size() != 10 || s[4] != '-' || s[7] != '-') return false;
-    for (int i : {0,1,2,3,5,6,8,9})
-        if (!std::isdigit(s[i])) return false;
-
-    int month = std::stoi(s.substr(5, 2));
-    int day = std::stoi(s.substr(8, 2));
-
-    if (month < 1 || month > 12) return false;
-    if (day < 1 || day > 31) return false;
-
-    return true;
-}
-
-
 // Prompt until a valid date
 std::string getValidDate(const std::string& prompt) {
     std::string date;
@@ -69,17 +75,6 @@ std::string getValidDate(const std::string& prompt) {
     }
 }
 
-// Validate YYYY-MM
-bool isValidMonth(const std::string& s) {
-    if (s.size() != 7 || s[4] != '-') return false;
-    for (int i : {0,1,2,3,5,6})
-        if (!std::isdigit(s[i])) return false;
-
-    int monthNum = std::stoi(s.substr(5, 2));
-    return monthNum >= 1 && monthNum <= 12;
-}
-
-
 // Prompt until a valid month
 std::string getValidMonth(const std::string& prompt) {
     std::string month;
@@ -115,20 +110,321 @@ std::string getValidCategory(const std::vector<std::string>& cats, const std::st
     }
 }
 
-int main() {
+// Asks for each part of a combined search; every part is optional.
+Query getSearchQuery() {
+    std::vector<Predicate> terms;
+
+    if (getValidInt(1, 2, "Limit to a date range?\n1. Yes\n2. No\nEnter choice: ") == 1) {
+        std::string from = getValidDate("Enter start date (YYYY-MM-DD): ");
+        std::string to = getValidDate("Enter end date (YYYY-MM-DD): ");
+        if (to < from) std::swap(from, to);
+        int32_t first = 0, last = 0;
+        packDate(from, first);
+        packDate(to, last);
+        terms.push_back(Predicate::dateRange(first, last));
+    }
+
+    int type = getValidInt(1, 3, "Type:\n1. Income and expense\n2. Expense only\n3. Income only\nEnter choice: ");
+    if (type == 2) terms.push_back(Predicate::type(TransactionType::Expense));
+    if (type == 3) terms.push_back(Predicate::type(TransactionType::Income));
+
+    if (getValidInt(1, 2, "Limit to categories?\n1. Yes\n2. No\nEnter choice: ") == 1) {
+        std::vector<std::string> all;
+        for (const CategoryInfo& category : CATEGORIES) all.emplace_back(category.name);
+
+        std::vector<uint16_t> ids;
+        do {
+            uint16_t id = 0;
+            if (CategoryRegistry::find(getValidCategory(all, "Select a category:"), id)) ids.push_back(id);
+        } while (getValidInt(1, 2, "1. Done\n2. Also include another category\nEnter choice: ") == 2);
+        terms.push_back(Predicate::categories(ids));
+    }
+
+    double minAmount = getValidDouble(0.0, "Minimum amount (0 for none): ");
+    double maxAmount = getValidDouble(0.0, "Maximum amount (0 for none): ");
+    if (minAmount > 0) terms.push_back(Predicate::amountAtLeast(Money::fromDollars(minAmount)));
+    if (maxAmount > 0) terms.push_back(Predicate::amountAtMost(Money::fromDollars(maxAmount)));
+
+    Query query;
+    query.where = Predicate::allOf(terms);
+
+    int order = getValidInt(1, 4, "Sort by:\n1. File order\n2. Date\n3. Amount (largest first)\n4. Amount (smallest first)\nEnter choice: ");
+    const SortOrder orders[] = {SortOrder::File, SortOrder::Date, SortOrder::AmountDescending, SortOrder::AmountAscending};
+    query.order = orders[order - 1];
+
+    query.limit = static_cast<size_t>(getValidInt(0, 1000000, "Maximum rows to show (0 for all): "));
+    return query;
+}
+
+// Reads a whole option value as a number no larger than max. Signs, trailing
+// text and out-of-range values are refused rather than wrapped or truncated.
+template <typename T>
+bool parseCountArg(const char* text, T& value, T max = std::numeric_limits<T>::max()) {
+    const char* end = text + std::strlen(text);
+    T parsed = 0;
+    auto result = std::from_chars(text, end, parsed);
+    if (result.ec != std::errc() || result.ptr != end || parsed > max) return false;
+    value = parsed;
+    return true;
+}
+
+// Reads a whole option value as a fraction in [0, 1] (1e999, nan and 0.2abc are refused).
+bool parseFractionArg(const char* text, double& value) {
+    char* end = nullptr;
+    errno = 0;
+    double parsed = std::strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !(parsed >= 0 && parsed <= 1)) return false;
+    value = parsed;
+    return true;
+}
+
+// Prints the command line options
+void printUsage() {
+    std::cout << "Usage: main.exe [--binary | --segments] [--threads N] [--format F] [--offset N] [--limit N] [--page N]\n"
+              << "       main.exe [--binary] [--format F] [--offset N] [--limit N] --list\n"
+              << "       main.exe [--binary] --import <file> [--batch N]\n"
+              << "       main.exe [--binary | --segments] [--format F] --budget-report [file]\n"
+              << "       main.exe [--binary | --segments] [--format F] [--limit N] --daemon\n"
+              << "       main.exe --client <request> [fields...]\n"
+              << "       main.exe --generate <rows> <file> [--seed S]\n"
+              << "       main.exe --to-binary [text ledger] [binary ledger]\n"
+              << "       main.exe --to-text [binary ledger] [text ledger]\n"
+              << "       main.exe --to-segments [text ledger]\n"
+              << "  --binary     use data/transactions.bin instead of data/transactions.txt\n"
+              << "  --segments   use the per-month files in data/ledger/ (monthly reports read one file)\n"
+              << "  --no-snapshot  ignore data/snapshot.bin and parse the whole text ledger\n"
+              << "  --compact-at F  rewrite the text ledger once deleted rows and edit records pass this\n"
+              << "               share of it (0 to 1, default 0.2; 1 never compacts)\n"
+              << "  --threads N  threads used to load a large text ledger (up to 1024, default: one per core)\n"
+              << "  --format F   listings as table (default), csv or jsonl (one JSON object per line)\n"
+              << "  --offset N   skip the first N rows of every listing\n"
+              << "  --limit N    print at most N rows of every listing\n"
+              << "  --page N     table listings stop every N rows and wait for Enter (q stops)\n"
+              << "  --list       print the saved transactions and exit\n"
+              << "  --stats      print timings and counters after every action and a JSON summary on exit\n"
+              << "               (to stderr with --format csv or jsonl)\n"
+              << "  --stats-json FILE  enable --stats and write the JSON summary to FILE instead\n"
+              << "  --import     append every valid row of a CSV file to the ledger and exit\n"
+              << "  --batch N    rows written and synced together during --import (default 10000)\n"
+              << "  --budget-report  print budget vs actual for every month and exit; with a file, save it there as CSV\n"
+              << "  --daemon     keep the ledger loaded and answer --client requests on " << SOCKET_PATH << "\n"
+              << "  --client     send one request to the daemon, e.g. --client report 2025-05 (see LedgerDaemon.h)\n"
+              << "  --generate   write a synthetic ledger with the given number of rows and exit\n"
+              << "  --seed S     generator seed (default 42); the same seed gives the same file\n"
+              << "  --to-binary  convert the text ledger to the binary format and exit\n"
+              << "  --to-text    convert the binary ledger back to text and exit\n"
+              << "  --to-segments  split the text ledger into data/ledger/YYYY-MM.csv plus a manifest and exit\n";
+}
+
+// Sends one request to a running --daemon and prints its answer.
+int runClient(const std::vector<std::string>& fields) {
+    std::string error;
+    if (!LedgerDaemon::request(SOCKET_PATH, fields, std::cout, error)) {
+        std::cout << "Error: " << error << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Converts between the text and binary ledgers. Paths default to the files in data/.
+int runConversion(const std::string& command, int argc, char* argv[]) {
+    std::string textPath = "data/transactions.txt";
+    std::string binaryPath = "data/transactions.bin";
+    bool toBinary = command == "--to-binary";
+
+    if (argc > 2) {
+        printUsage();
+        return 1;
+    }
+    if (argc >= 1) (toBinary ? textPath : binaryPath) = argv[0];
+    if (argc >= 2) (toBinary ? binaryPath : textPath) = argv[1];
+
+    std::string error;
+    size_t written = 0, skipped = 0;
+    bool ok = toBinary
+        ? BinaryLedger::convertTextToBinary(textPath, binaryPath, written, skipped, error)
+        : BinaryLedger::convertBinaryToText(binaryPath, textPath, written, error);
+
+    if (!ok) {
+        std::cout << "Error: " << error << "\n";
+        return 1;
+    }
+
+    std::cout << "Wrote " << written << " transactions to " << (toBinary ? binaryPath : textPath) << ".\n";
+    if (skipped > 0) std::cout << "Skipped " << skipped << " invalid lines.\n";
+    return 0;
+}
+
+// Prints the profiler's last action to console and writes its JSON summary (to path, or console).
+// No-op without --stats.
+void reportStats(const std::string& path, bool exiting, std::ostream& console) {
+    if (!Profiler::enabled()) return;
+    Profiler::printRecent(console);
+    if (!exiting) return;
+
+    if (path.empty()) {
+        Profiler::writeJson(console);
+        return;
+    }
+    std::ofstream out(path);
+    if (!out) {
+        console << "Error: Could not write " << path << ".\n";
+        return;
+    }
+    Profiler::writeJson(out);
+}
+
+// Splits the text ledger into month segments under data/ledger.
+int runSegmentMigration(int argc, char* argv[]) {
+    std::string textPath = argc >= 1 ? argv[0] : "data/transactions.txt";
+    if (argc > 1) {
+        printUsage();
+        return 1;
+    }
+
+    std::string error;
+    size_t written = 0, skipped = 0;
+    if (!SegmentedLedger::migrate(textPath, "data/ledger", written, skipped, error)) {
+        std::cout << "Error: " << error << "\n";
+        return 1;
+    }
+
+    std::cout << "Wrote " << written << " transactions to data/ledger/. Run with --segments to use them.\n";
+    if (skipped > 0) std::cout << "Skipped " << skipped << " invalid lines.\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    LedgerFormat format = LedgerFormat::Text;
+    unsigned threads = 0;
+    std::string importPath;
+    size_t batchSize = 10000;
+    OutputOptions output;
+    bool listOnly = false;
+    std::string generatePath;
+    uint64_t generateRows = 0, seed = 42;
+    std::string statsPath;
+    bool useSnapshot = true;
+    bool daemonMode = false;
+    bool budgetReport = false;
+    std::string budgetReportPath;
+    double compactionFraction = 0.2;
+
+    // Command line options
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--binary") {
+            format = LedgerFormat::Binary;
+        } else if (arg == "--segments") {
+            format = LedgerFormat::Segmented;
+        } else if (arg == "--to-segments") {
+            return runSegmentMigration(argc - i - 1, argv + i + 1);
+        } else if (arg == "--threads" && i + 1 < argc && parseCountArg(argv[i + 1], threads, MAX_THREADS)) {
+            ++i;
+        } else if (arg == "--format" && i + 1 < argc && parseOutputFormat(argv[i + 1], output.format)) {
+            ++i;
+        } else if ((arg == "--offset" || arg == "--limit" || arg == "--page") &&
+                   i + 1 < argc && parseCountArg(argv[i + 1],
+                       arg == "--offset" ? output.offset : arg == "--limit" ? output.limit : output.pageSize)) {
+            ++i;
+        } else if (arg == "--no-snapshot") {
+            useSnapshot = false;
+        } else if (arg == "--compact-at" && i + 1 < argc && parseFractionArg(argv[i + 1], compactionFraction)) {
+            ++i;
+        } else if (arg == "--stats") {
+            Profiler::enable();
+        } else if (arg == "--stats-json" && i + 1 < argc) {
+            Profiler::enable();
+            statsPath = argv[++i];
+        } else if (arg == "--daemon") {
+            daemonMode = true;
+        } else if (arg == "--client" && i + 1 < argc) {
+            return runClient(std::vector<std::string>(argv + i + 1, argv + argc));
+        } else if (arg == "--list") {
+            listOnly = true;
+        } else if (arg == "--budget-report") {
+            budgetReport = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') budgetReportPath = argv[++i];
+        } else if (arg == "--generate" && i + 2 < argc && parseCountArg(argv[i + 1], generateRows)) {
+            ++i;
+            generatePath = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc && parseCountArg(argv[i + 1], seed)) {
+            ++i;
+        } else if (arg == "--import" && i + 1 < argc) {
+            importPath = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc && parseCountArg(argv[i + 1], batchSize)) {
+            ++i;
+        } else if (arg == "--to-binary" || arg == "--to-text") {
+            return runConversion(arg, argc - i - 1, argv + i + 1);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (!generatePath.empty()) {
+        std::string error;
+        if (!LedgerGenerator::writeText(generatePath, generateRows, seed, error)) {
+            std::cout << "Error: " << error << "\n";
+            return 1;
+        }
+        std::cout << "Wrote " << generateRows << " transactions to " << generatePath << ".\n";
+        return 0;
+    }
+
+    // csv and jsonl output is meant for other programs, so the stats stay out of it.
+    std::ostream& statsOut = output.format == OutputFormat::Table ? std::cout : std::cerr;
+
+    if (daemonMode && Profiler::enabled()) {
+        std::cout << "Error: --stats cannot be combined with --daemon.\n";
+        return 1;
+    }
+    if (daemonMode) output.pageSize = 0; // nobody is at the daemon's console to press Enter
+
     std::vector<Transaction> transactions;    // in-memory list
-    FinanceManager manager;                 // manager instance
+    FinanceManager manager(format, threads, useSnapshot); // manager instance
+    manager.setOutputOptions(output);
+    manager.setCompactionFraction(compactionFraction);
     int choice;
 
-    // Predefined categories
-    const std::vector<std::string> expenseCategories = {
-        "Bills","Charity","Eating Out","Entertainment","Expenses","Family",
-        "Finances","General","Gifts","Groceries","Holidays","Personal Care",
-        "Savings","Shopping","Transfers","Transport"
-    };
-    const std::vector<std::string> incomeCategories = {
-        "Salary","Freelance","Investments","Gifts","Other"
-    };
+    // Predefined categories, in menu order
+    const std::vector<std::string> expenseCategories = CategoryRegistry::names(TransactionType::Expense);
+    const std::vector<std::string> incomeCategories = CategoryRegistry::names(TransactionType::Income);
+
+    if (daemonMode) {
+        LedgerDaemon daemon(manager, SOCKET_PATH, threads);
+        std::string error;
+        if (!daemon.run(error)) {
+            std::cout << "Error: " << error << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (listOnly) {
+        manager.loadTransactionsFromFile();
+        manager.saveSnapshot();
+        reportStats(statsPath, true, statsOut);
+        return 0;
+    }
+
+    if (budgetReport) {
+        bool ok = true;
+        if (budgetReportPath.empty()) manager.showBudgetReport();
+        else ok = manager.exportBudgetReport(budgetReportPath);
+        manager.saveSnapshot();
+        reportStats(statsPath, true, statsOut);
+        return ok ? 0 : 1;
+    }
+
+    if (!importPath.empty()) {
+        bool ok = manager.importTransactions(importPath, batchSize);
+        manager.saveSnapshot();
+        reportStats(statsPath, true, statsOut);
+        return ok ? 0 : 1;
+    }
+
+    reportStats(statsPath, false, statsOut); // startup load
 
     do {
         // Main menu
@@ -144,21 +440,27 @@ int main() {
         std::cout << "7. Filter Transactions by Amount\n";
         std::cout << "8. Generate Monthly Report\n";
         std::cout << "9. Show Monthly Expense Bar Chart\n";
-        std::cout << "10. Exit\n";
+        std::cout << "10. Filter Transactions by Date Range\n";
+        std::cout << "11. Search Transactions (combine filters)\n";
+        std::cout << "12. Range Report (by month, quarter or year)\n";
+        std::cout << "13. Spending Analysis (largest expenses, median/p90/p99)\n";
+        std::cout << "14. Budget vs Actual (every month, CSV export)\n";
+        std::cout << "15. Edit or Delete a Transaction\n";
+        std::cout << "16. Exit\n";
 
-        choice = getValidInt(1, 10, "Enter your choice: ");
+        choice = getValidInt(1, 16, "Enter your choice: ");
 
         if (choice == 1) {
             // Add and save
             std::string type = getValidType();
-            double amount = getValidDouble(0.0, "Enter amount: ");
+            Money amount = Money::fromDollars(getValidDouble(0.0, "Enter amount: "));
             std::string category = getValidCategory(
                 type == "expense" ? expenseCategories : incomeCategories,
                 "Select a " + type + " category:"
             );
             std::string date = getValidDate("Enter date (YYYY-MM-DD): ");
 
-            Transaction t(type, amount, category, date);
+            Transaction t(type, amount, std::move(category), date);
             transactions.push_back(t);
             manager.saveTransactionToFile(t);
             std::cout << "Transaction added.\n";
@@ -166,9 +468,9 @@ int main() {
             // Check budget
             if (type == "expense") {
                 std::string month = date.substr(0, 7);
-                double total = manager.getMonthlyExpenseTotal(month);
-                double budget = manager.getMonthlyBudget(month);
-                if (budget > 0 && total > budget) {
+                Money total = manager.getMonthlyExpenseTotal(month);
+                Money budget = manager.getMonthlyBudget(month);
+                if (budget > Money() && total > budget) {
                     std::cout << "Budget of $" << budget
                               << " exceeded for " << month << ".\n";
                 }
@@ -178,8 +480,12 @@ int main() {
             if (transactions.empty()) {
                 std::cout << "No transactions recorded.\n";
             } else {
-                std::cout << "\nTransactions (this session):\n";
-                for (auto& t : transactions) t.display();
+                ResultWriter writer(std::cout, output);
+                writer.note("\nTransactions (this session):\n");
+                for (auto& t : transactions) {
+                    if (!writer.row(t)) break;
+                }
+                writer.finish(transactions.size());
             }
 
         } else if (choice == 3) {
@@ -188,13 +494,17 @@ int main() {
         } else if (choice == 4) {
             // Set monthly budget
             std::string month = getValidMonth("Enter month for budget (YYYY-MM): ");
-            double budget = getValidDouble(0.0, "Enter budget amount: ");
+            Money budget = Money::fromDollars(getValidDouble(0.0, "Enter budget amount: "));
             manager.setMonthlyBudget(month, budget);
 
         } else if (choice == 5) {
-            // Filter by category
-            std::string cat = getValidCategory(expenseCategories, "Select a category to filter:");
-            manager.filterTransactionsByCategory(cat);
+            // Filter by one or more categories
+            std::vector<std::string> cats;
+            cats.push_back(getValidCategory(expenseCategories, "Select a category to filter:"));
+            while (getValidInt(1, 2, "1. Show results\n2. Also include another category\nEnter choice: ") == 2) {
+                cats.push_back(getValidCategory(expenseCategories, "Select another category:"));
+            }
+            manager.filterTransactionsByCategories(cats);
 
         } else if (choice == 6) {
             // Filter by date
@@ -203,10 +513,15 @@ int main() {
 
         } else if (choice == 7) {
             // Filter by amount
-            double amt = getValidDouble(0.0, "Enter amount to filter by: ");
+            Money amt = Money::fromDollars(getValidDouble(0.0, "Enter amount to filter by: "));
             int ft = getValidInt(1, 2,
                 "1. >= amount\n2. <= amount\nEnter choice: ");
-            manager.filterTransactionsByAmount(amt, ft == 1);
+            int tt = getValidInt(1, 3,
+                "1. Income and expense\n2. Expense only\n3. Income only\nEnter choice: ");
+            std::optional<TransactionType> type;
+            if (tt == 2) type = TransactionType::Expense;
+            if (tt == 3) type = TransactionType::Income;
+            manager.filterTransactionsByAmount(amt, ft == 1, type);
 
         } else if (choice == 8) {
             // Monthly report
@@ -218,8 +533,77 @@ int main() {
             std::string month = getValidMonth("Enter month for chart (YYYY-MM): ");
             manager.showExpenseBarChart(month);
 
+        } else if (choice == 10) {
+            // Filter by date range
+            std::string from = getValidDate("Enter start date (YYYY-MM-DD): ");
+            std::string to = getValidDate("Enter end date (YYYY-MM-DD): ");
+            if (to < from) std::swap(from, to); // same-format dates compare as text
+            manager.filterTransactionsByDateRange(from, to);
+
+        } else if (choice == 11) {
+            // Combined search
+            manager.searchTransactions(getSearchQuery());
+
+        } else if (choice == 12) {
+            // Range report
+            std::string from = getValidMonth("Enter first month (YYYY-MM): ");
+            std::string to = getValidMonth("Enter last month (YYYY-MM): ");
+            int period = getValidInt(1, 3, "Group by:\n1. Month\n2. Quarter\n3. Year\nEnter choice: ");
+            const ReportPeriod periods[] = {ReportPeriod::Month, ReportPeriod::Quarter, ReportPeriod::Year};
+            manager.generateRangeReport(from, to, periods[period - 1]);
+
+        } else if (choice == 13) {
+            // Largest expenses or typical expense sizes, from the running statistics
+            int kind = getValidInt(1, 2, "1. Largest expenses\n2. Median, p90 and p99 per category\nEnter choice: ");
+            std::string month;
+            if (getValidInt(1, 2, "Limit to one month?\n1. Yes\n2. No\nEnter choice: ") == 1) {
+                month = getValidMonth("Enter month (YYYY-MM): ");
+            }
+            if (kind == 1) {
+                std::string category;
+                if (getValidInt(1, 2, "Limit to one category?\n1. Yes\n2. No\nEnter choice: ") == 1) {
+                    category = getValidCategory(expenseCategories, "Select a category:");
+                }
+                int count = getValidInt(1, static_cast<int>(TopAmounts::CAPACITY), "How many (1-10): ");
+                manager.showLargestExpenses(static_cast<size_t>(count), month, category);
+            } else {
+                manager.showSpendingDistribution(month);
+            }
+
+        } else if (choice == 14) {
+            // Budget adherence across the whole history, optionally saved for other tools
+            manager.showBudgetReport();
+            if (getValidInt(1, 2, "Save as CSV?\n1. Yes\n2. No\nEnter choice: ") == 1) {
+                std::string path;
+                std::cout << "Enter file name (Enter for " << BUDGET_REPORT_PATH << "): ";
+                std::getline(std::cin, path);
+                manager.exportBudgetReport(path.empty() ? BUDGET_REPORT_PATH : path);
+            }
+
+        } else if (choice == 15) {
+            // Find the transaction by its day, then change or remove it by id
+            std::string day = getValidDate("Enter the date of the transaction (YYYY-MM-DD): ");
+            manager.showTransactionsWithIds(day);
+            size_t id = static_cast<size_t>(getValidInt(0, std::numeric_limits<int>::max(),
+                                                        "Enter the transaction id (the number after #): "));
+            int action = getValidInt(1, 3, "1. Edit it\n2. Delete it\n3. Cancel\nEnter choice: ");
+            if (action == 1) {
+                std::string type = getValidType();
+                Money amount = Money::fromDollars(getValidDouble(0.0, "Enter amount: "));
+                std::string category = getValidCategory(
+                    type == "expense" ? expenseCategories : incomeCategories,
+                    "Select a " + type + " category:"
+                );
+                std::string date = getValidDate("Enter date (YYYY-MM-DD): ");
+                manager.replaceTransaction(id, Transaction(type, amount, std::move(category), date));
+            } else if (action == 2) {
+                manager.deleteTransaction(id);
+            }
         }
-    } while (choice != 10);
+
+        if (choice == 16) manager.saveSnapshot();
+        reportStats(statsPath, choice == 16, statsOut);
+    } while (choice != 16);
 
     return 0;   // Exit
 }